@@ -24,15 +24,29 @@ CONDA_DIR="$DATA_DIR/conda_envs"
 CONDA_ENV_SRC="/tmp/my-test-env" # Local scratch path
 CONDA_ENV_DEST="$CONDA_DIR/test_env_node_A"
 
+# Seeded C++ generator (src/data_plane). When built, it creates sections 1-3
+# in parallel with reproducible content and records them in
+# $DATA_DIR/manifest.txt, so reruns only (re)generate what is missing.
+DATA_PLANE_GEN="${DATA_PLANE_GEN:-$(dirname "$0")/build/src/data_plane/data_plane_gen}"
+DATA_PLANE_SEED="${DATA_PLANE_SEED:-42}"
+
 # --- Script Start ---
 echo "Checking Data Plane at $DATA_DIR..."
 mkdir -p "$LARGE_FILE_DIR"
 mkdir -p "$DATASET_DIR"
 mkdir -p "$CONDA_DIR"
 
+if [ -x "$DATA_PLANE_GEN" ]; then
+    echo "Generating Large Binaries, Small File Dataset and Tarball with $DATA_PLANE_GEN..."
+    "$DATA_PLANE_GEN" --data-dir "$DATA_DIR" --seed "$DATA_PLANE_SEED" ${DATA_PLANE_VERIFY:+--verify}
+    SKIP_SHELL_GENERATION=1
+fi
+
 # --- 1. Large Binaries (for Req 5) ---
 echo "Checking for Large Binaries..."
-if [ ! -f "$LARGE_FILE_32G" ]; then
+if [ -n "${SKIP_SHELL_GENERATION:-}" ]; then
+    echo "  -> Handled by data_plane_gen."
+elif [ ! -f "$LARGE_FILE_32G" ]; then
     echo "  -> Generating 32GB file (file_32G.bin)..."
     dd if=/dev/urandom of="$LARGE_FILE_32G" bs=1G count=32 status=progress
 else
@@ -42,7 +56,9 @@ fi
 # --- 2. Small/Medium Files (for Req 1, 2) ---
 echo "Checking for Small File Dataset..."
 # We check if the directory is missing OR if it's empty
-if [ ! -d "$SMALL_FILE_DIR" ] || [ -z "$(ls -A "$SMALL_FILE_DIR" 2>/dev/null)" ]; then
+if [ -n "${SKIP_SHELL_GENERATION:-}" ]; then
+    echo "  -> Handled by data_plane_gen."
+elif [ ! -d "$SMALL_FILE_DIR" ] || [ -z "$(ls -A "$SMALL_FILE_DIR" 2>/dev/null)" ]; then
     echo "  -> Generating 100k small text files in small_files_text/..."
     mkdir -p "$SMALL_FILE_DIR" # Ensure it exists
     for i in $(seq 1 100000); do
@@ -54,7 +70,9 @@ fi
 
 # --- 3. Large Tarball (for Req 2) ---
 echo "Checking for Large Tarball..."
-if [ ! -f "$TARBALL_PATH" ]; then
+if [ -n "${SKIP_SHELL_GENERATION:-}" ]; then
+    echo "  -> Handled by data_plane_gen."
+elif [ ! -f "$TARBALL_PATH" ]; then
     echo "  -> Creating large tarball (large_tarball.tar) from small files..."
     # Ensure source directory is not empty before tarring
     if [ -z "$(ls -A "$SMALL_FILE_DIR" 2>/dev/null)" ]; then
@@ -1,7 +1,9 @@
+#include <chrono>
 #include <condition_variable>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #include <grpc/grpc.h>
 #include <grpcpp/channel.h>
@@ -9,70 +11,306 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 
+#include "../comm_utils/communicator.hpp"
+#include "../fs_test/progress.hpp"
+#include "../fs_test/proto_convert.hpp"
+#include "../fs_test/test_common.hpp"
+#include "../fs_test/test_registry.hpp"
+
 #include "../../protos/hpcfs_bench.pb.h"
 #include "../../protos/hpcfs_bench.grpc.pb.h"
 
 
-class ClusterClient : public grpc::ClientBidiReactor<hpcfs_bench::TestResult, hpcfs_bench::TestRequest> {
+/**
+ * @brief Worker end of the Comm stream.
+ *
+ * The reactor only moves messages: received TestParams go onto the
+ * communicator's receive queue, and TestResults queued by the test loop are
+ * written back as soon as the stream is free. Tests themselves run on the
+ * caller's thread (see run()), so a long test never stalls gRPC callbacks and
+ * the next params are already queued locally when it finishes.
+ *
+ * No callback blocks. Params that find the receive queue full are held back,
+ * with the stream's next read, until run() drains it (the communicator's
+ * drain notifier); a clock probe's answer skips the send queue, which
+ * progress samples may have filled, and the next read waits until it is
+ * written. Since reads then restart from outside a callback, the read flow
+ * holds the stream open (AddHold()) until a read fails.
+ */
+class ClusterClient : public grpc::ClientBidiReactor<hpcfs_bench::TestResult, hpcfs_bench::TestParams> {
 private:
 
     std::shared_ptr<grpc::Channel> channel;
     std::unique_ptr<hpcfs_bench::ClusterService::Stub> stub;
     grpc::ClientContext context;
 
-    hpcfs_bench::TestRequest request;
+    hpcfs_bench::TestParams request;
     hpcfs_bench::TestResult result;
 
+    Communicator<hpcfs_bench::TestResult, hpcfs_bench::TestParams> communicator;
+    bool write_in_progress = false;
+    /** @brief Answer to the last clock probe, written ahead of the send queue; no read is pending meanwhile. */
+    hpcfs_bench::TestResult probe_answer;
+    bool probe_pending = false;
+    /** @brief The write in progress is probe_answer, so its OnWriteDone() restarts the read. */
+    bool writing_probe = false;
+    /** @brief Guards read_stalled; held across try_queue_receive() so a drain can't slip in between. */
+    std::mutex stall_mtx;
+    /** @brief `request` is waiting for room in the receive queue; no read is pending. */
+    bool read_stalled = false;
+
+    /** @brief The test instance living between SETUP and CLEANUP. */
+    std::unique_ptr<BaseTest> test;
+    std::string test_name;
+    /** @brief test's worker_setup() succeeded, so ARM and EXECUTE may use it. */
+    bool set_up = false;
+
     grpc::Status status;
     std::mutex mutex;
     std::condition_variable cv;
     bool done = false;
-    
+
+    /**
+     * @brief Writes the pending probe answer, else the next queued result, if
+     * no write is in progress. StartWrite() is called without holding the
+     * mutex, since gRPC may run OnWriteDone() inline.
+     */
+    void try_start_write() {
+        {
+            std::unique_lock<std::mutex> l(mutex);
+            if (done || write_in_progress) return;
+            if (probe_pending) {
+                result = std::move(probe_answer);
+                probe_pending = false;
+                writing_probe = true;
+            } else if (!communicator.get_send_queue().try_pop(result)) {
+                return;
+            }
+            write_in_progress = true;
+        }
+        if (result.has_probe()) result.mutable_probe()->set_worker_send_ns(realtime_ns());
+        StartWrite(&result);
+    }
+
+    /** @brief Drain notifier: queues the held-back params, if any, and resumes reading. */
+    void resume_read() {
+        {
+            std::lock_guard<std::mutex> lock(stall_mtx);
+            if (!read_stalled || !communicator.try_queue_receive(std::move(request))) return;
+            read_stalled = false;
+        }
+        request.Clear();
+        StartRead(&request);
+    }
+
 public:
     ClusterClient() {
         channel = std::shared_ptr<grpc::Channel>(grpc::CreateChannel("0.0.0.0:8000", grpc::InsecureChannelCredentials()));
         stub = hpcfs_bench::ClusterService::NewStub(channel);
+        communicator.set_send_notifier([this] { try_start_write(); });
+        communicator.set_drain_notifier([this] { resume_read(); });
         stub->async()->Comm(&context, this);
-        StartWrite(&result);
+        AddHold(); // Released once a read fails: resume_read() may restart reads from run()'s thread
         StartRead(&request);
         StartCall();
         std::cout << "Client created" << std::endl;
     }
-    void perform_test(const hpcfs_bench::TestRequest& req, hpcfs_bench::TestResult& res) {
-        std::cout << "Performing test: " << req.DebugString() << std::endl;
+    ~ClusterClient() {
+        communicator.set_send_notifier(nullptr);
+        communicator.set_drain_notifier(nullptr);
+    }
+    /**
+     * @brief Blocks until CLOCK_REALTIME reaches target_ns: sleeps until
+     * shortly before, then spins so the wakeup isn't at the mercy of the
+     * scheduler's timer slack.
+     * @return How late (ns) we actually returned.
+     */
+    static uint64_t wait_until_realtime(uint64_t target_ns) {
+        const uint64_t spin_window_ns = 200000;
+        uint64_t now = realtime_ns();
+        if (now + spin_window_ns < target_ns) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(target_ns - now - spin_window_ns));
+        }
+        while ((now = realtime_ns()) < target_ns) {}
+        return now - target_ns;
     }
-    void OnReadDone(bool ok) override {
-        if (ok) {
-            // hpcfs_bench::TestResult result = GetReadMessage();
-            std::cout << "Received TestResult: " << request.DebugString() << std::endl;
 
-            // perform test
-            perform_test(request, request);
+    /** @brief Whether `test` is a set-up instance of req.test_name. */
+    bool is_set_up(const hpcfs_bench::TestParams& req) const {
+        return test && set_up && test_name == req.test_name();
+    }
 
-            // send results back to server
-            StartWrite(result);
+    hpcfs_bench::TestResult perform_test(const hpcfs_bench::TestParams& req) {
+        hpcfs_bench::TestResult res;
+        if (req.phase() == hpcfs_bench::NOOP) {
+            res.set_correct(true);
+            return res;
+        }
 
-            // Continue reading
-            StartRead(&request);
+        TestContext context;
+        from_proto(req, context);
+        // SETUP makes a fresh instance that lives until CLEANUP. An EXECUTE
+        // with no SETUP before it (a one-off rpc_call_execute()) gets an
+        // instance of its own, dropped afterwards.
+        std::unique_ptr<BaseTest> one_shot;
+        if (req.phase() == hpcfs_bench::SETUP || (req.phase() == hpcfs_bench::EXECUTE && !is_set_up(req))) {
+            std::unique_ptr<BaseTest> created = TestRegistry::instance().create(req.test_name(), context);
+            if (!created) {
+                res.set_correct(false);
+                res.set_message("Unknown test: " + req.test_name());
+                return res;
+            }
+            if (req.phase() == hpcfs_bench::SETUP) {
+                test = std::move(created);
+                test_name = req.test_name();
+                set_up = false;
+            } else {
+                one_shot = std::move(created);
+            }
+        }
+
+        TestResult outcome;
+        switch (req.phase()) {
+            case hpcfs_bench::SETUP:
+                set_up = test->worker_setup(context);
+                outcome.success = set_up;
+                if (!outcome.success) outcome.error_msg = "worker_setup failed";
+                break;
+            case hpcfs_bench::ARM:
+                // Answering is the point, but only a worker that is really set up may say it is ready.
+                if (!is_set_up(req)) {
+                    outcome.success = false;
+                    outcome.error_msg = "ARM without a successful SETUP of " + req.test_name();
+                }
+                break;
+            case hpcfs_bench::EXECUTE: {
+                BaseTest* target = one_shot ? one_shot.get() : test.get();
+                uint64_t late_ns = req.start_at_ns() ? wait_until_realtime(req.start_at_ns()) : 0;
+                std::unique_ptr<ProgressSampler> sampler;
+                if (req.progress_interval_ms()) {
+                    // Samples go out on the stream as they are taken, tagged
+                    // with this request's id; the server files them separately.
+                    uint64_t request_id = req.request_id();
+                    sampler = std::make_unique<ProgressSampler>(
+                        std::chrono::milliseconds(req.progress_interval_ms()),
+                        [this, request_id](uint64_t t_ns, uint64_t bytes, uint64_t ops) {
+                            hpcfs_bench::TestResult msg;
+                            msg.set_request_id(request_id);
+                            msg.mutable_progress()->set_t_ns(t_ns);
+                            msg.mutable_progress()->set_bytes(bytes);
+                            msg.mutable_progress()->set_ops(ops);
+                            communicator.queue_send(std::move(msg));
+                        });
+                }
+                {
+                    // Every result gets the os_* metrics: CPU, faults and I/O the OS charged to the run.
+                    ResourceScope usage(ResourceScope::PROCESS);
+                    outcome = target->worker_execute(context);
+                    usage.report(outcome.metrics);
+                }
+                // Stopping queues the last sample, ahead of the result itself.
+                if (sampler) sampler->stop();
+                if (req.start_at_ns()) outcome.metrics["start_late_ns"] = late_ns;
+                break;
+            }
+            case hpcfs_bench::CLEANUP:
+                // Also after a failed SETUP, to undo whatever it got done; nothing to do without one.
+                if (test && test_name == req.test_name()) test->worker_cleanup(context);
+                test.reset();
+                test_name.clear();
+                set_up = false;
+                break;
+            default:
+                outcome.success = false;
+                outcome.error_msg = "Unknown phase";
+                break;
+        }
+        to_proto(outcome, &res);
+        return res;
+    }
+    /**
+     * @brief Runs tests as they arrive until the stream closes.
+     */
+    void run() {
+        for (;;) {
+            hpcfs_bench::TestParams params = communicator.receive();
+            {
+                std::unique_lock<std::mutex> l(mutex);
+                if (done) return;
+            }
+            hpcfs_bench::TestResult res = perform_test(params);
+            res.set_request_id(params.request_id());
+            communicator.queue_send(std::move(res));
+        }
+    }
+    void OnReadDone(bool ok) override {
+        if (ok && request.phase() == hpcfs_bench::CLOCK_PROBE) {
+            // Answer clock probes right here rather than behind a running
+            // test, so the worker-side timestamps bracket only our own hop.
+            hpcfs_bench::TestResult res;
+            res.set_correct(true);
+            res.set_request_id(request.request_id());
+            *res.mutable_probe() = request.probe();
+            res.mutable_probe()->set_worker_recv_ns(realtime_ns());
+            // Written ahead of the send queue; the next read starts once it is out (OnWriteDone()).
+            {
+                std::unique_lock<std::mutex> l(mutex);
+                probe_answer = std::move(res);
+                probe_pending = true;
+            }
+            try_start_write();
+        } else if (ok) {
+            // hand the params to the test loop and keep reading; if its queue
+            // is full, stop reading until run() drains it (resume_read())
+            // rather than block here
+            bool queued;
+            {
+                std::lock_guard<std::mutex> lock(stall_mtx);
+                queued = communicator.try_queue_receive(std::move(request));
+                read_stalled = !queued;
+            }
+            if (queued) {
+                request.Clear();
+                StartRead(&request);
+            }
         } else {
-            std::cout << "No more TestResults from server." << std::endl;
+            std::cout << "No more TestParams from server." << std::endl;
+            RemoveHold();
         }
     }
     void OnWriteDone(bool ok) override {
-        if (ok) {
-            std::cout << "TestRequest sent successfully." << std::endl;
-        } else {
-            std::cout << "Failed to send TestRequest." << std::endl;
+        bool probe_written;
+        {
+            std::unique_lock<std::mutex> l(mutex);
+            probe_written = writing_probe;
+            writing_probe = false;
+            if (ok) write_in_progress = false;
+        }
+        // Resume the read held back for the probe answer; on a broken stream
+        // it fails, which ends the read flow and releases its hold.
+        if (probe_written) {
+            request.Clear();
+            StartRead(&request);
+        }
+        if (!ok) {
+            std::cout << "Failed to send TestResult." << std::endl;
+            return;
         }
+        try_start_write();
     }
     void OnDone(const grpc::Status& status) override {
-        std::unique_lock<std::mutex> l(mutex);
-        this->status = status;
-        done = true;
+        {
+            std::unique_lock<std::mutex> l(mutex);
+            this->status = status;
+            done = true;
+        }
         cv.notify_all();
+        // Wake the test loop so run() can return. A full queue needs no
+        // wakeup: run() sees done after its next receive().
+        communicator.try_queue_receive(hpcfs_bench::TestParams());
         std::cout << "Client done" << std::endl;
     }
-    Status Await() {
+    grpc::Status Await() {
         std::unique_lock<std::mutex> l(mutex);
         cv.wait(l, [this] { return done; });
         return std::move(status);
@@ -82,6 +320,7 @@ public:
 
 int main() {
     ClusterClient client;
+    client.run();
     client.Await();
     return 0;
 }
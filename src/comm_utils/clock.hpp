@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Monotonic timestamp in nanoseconds, for per-operation latencies.
+ */
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/**
+ * @brief Wall-clock (CLOCK_REALTIME) timestamp in nanoseconds.
+ * Only for timestamps compared across machines; use now_ns() for durations.
+ */
+inline uint64_t realtime_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
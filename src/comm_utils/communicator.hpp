@@ -1,11 +1,45 @@
-#include "safe_queue.hpp"
+#pragma once
+
+#include <functional>
+#include <mutex>
+
+#include "ring_queue.hpp"
 
 template <typename S, typename R>
 class Communicator {
 private:
-    SafeQueue<S> send_queue;
-    SafeQueue<R> recv_queue;
+    RingQueue<S> send_queue;
+    RingQueue<R> recv_queue;
+
+    std::mutex notifier_mtx;
+    std::function<void()> send_notifier;
+    std::function<void()> receive_notifier;
+    // Separate lock: a drain notifier typically queues a held-back message,
+    // which runs the receive notifier.
+    std::mutex drain_mtx;
+    std::function<void()> drain_notifier;
+
+    void notify_sender() {
+        std::lock_guard<std::mutex> lock(notifier_mtx);
+        if (send_notifier) send_notifier();
+    }
+    void notify_receiver() {
+        std::lock_guard<std::mutex> lock(notifier_mtx);
+        if (receive_notifier) receive_notifier();
+    }
+    void notify_drained() {
+        std::lock_guard<std::mutex> lock(drain_mtx);
+        if (drain_notifier) drain_notifier();
+    }
 public:
+    /**
+     * @param queue_capacity Bound on each direction's queue. Producers block
+     * (spin, then sleep) when a queue is full instead of growing memory;
+     * try_queue_receive() is the non-blocking alternative.
+     */
+    explicit Communicator(size_t queue_capacity = 1024)
+        : send_queue(queue_capacity), recv_queue(queue_capacity) {}
+
     /**
      * @brief Sends a message by pushing it onto the send queue.
      *
@@ -13,24 +47,74 @@ public:
      */
     void queue_send(const S& msg) {
         send_queue.push(msg);
+        notify_sender();
     }
 
     void queue_send(S&& msg) {
         send_queue.push(std::move(msg));
+        notify_sender();
+    }
+
+    /**
+     * @brief Registers a callback run after every queue_send().
+     *
+     * Lets an event-driven consumer (e.g. a gRPC reactor) pull from the send
+     * queue with try_pop() instead of blocking in send(). Pass nullptr to
+     * unregister; once that returns, the old callback is not running and will
+     * not run again, so its captures may be destroyed.
+     */
+    void set_send_notifier(std::function<void()> notifier) {
+        std::lock_guard<std::mutex> lock(notifier_mtx);
+        send_notifier = std::move(notifier);
     }
 
-    S&& send() {
+    /**
+     * @brief Registers a callback run after every queue_receive(), once the
+     * message is in the queue. Lets one consumer wait on many communicators
+     * (see ServerCommunicator::receive_any()). Same lifetime rules as
+     * set_send_notifier().
+     */
+    void set_receive_notifier(std::function<void()> notifier) {
+        std::lock_guard<std::mutex> lock(notifier_mtx);
+        receive_notifier = std::move(notifier);
+    }
+
+    /**
+     * @brief Registers a callback run after every receive() / try_receive()
+     * pop, i.e. whenever the receive queue gains room. Lets a producer that
+     * must not block (a gRPC reactor) hold a message back when
+     * try_queue_receive() fails and retry from here. Same lifetime rules as
+     * set_send_notifier().
+     */
+    void set_drain_notifier(std::function<void()> notifier) {
+        std::lock_guard<std::mutex> lock(drain_mtx);
+        drain_notifier = std::move(notifier);
+    }
+
+    S send() {
         S msg;
         send_queue.wait_and_pop(msg);
-        return std::move(msg);
+        return msg;
     }
 
     void queue_receive(const R& msg) {
         recv_queue.push(msg);
+        notify_receiver();
     }
 
     void queue_receive(R&& msg) {
-        recv_queue.push(msg);
+        recv_queue.push(std::move(msg));
+        notify_receiver();
+    }
+
+    /**
+     * @brief Non-blocking queue_receive().
+     * @return false if the receive queue is full; msg is left untouched.
+     */
+    bool try_queue_receive(R&& msg) {
+        if (!recv_queue.try_push(std::move(msg))) return false;
+        notify_receiver();
+        return true;
     }
 
     /**
@@ -38,12 +122,20 @@ public:
      *
      * This method blocks until a message is available.
      *
-     * @param msg (out) A reference to store the received message.
+     * @return The received message.
      */
-    R&& receive() {
+    R receive() {
         R output;
         recv_queue.wait_and_pop(output);
-        return std::move(output);
+        notify_drained();
+        return output;
+    }
+
+    /** @brief Non-blocking receive(). @return false if nothing was queued. */
+    bool try_receive(R& out) {
+        if (!recv_queue.try_pop(out)) return false;
+        notify_drained();
+        return true;
     }
 
     /**
@@ -51,7 +143,7 @@ public:
      *
      * @return Reference to the send queue.
      */
-    SafeQueue<S>& get_send_queue() {
+    RingQueue<S>& get_send_queue() {
         return send_queue;
     }
 
@@ -60,7 +152,7 @@ public:
      *
      * @return Reference to the receive queue.
      */
-    SafeQueue<R>& get_recv_queue() {
+    RingQueue<R>& get_recv_queue() {
         return recv_queue;
     }
 };
\ No newline at end of file
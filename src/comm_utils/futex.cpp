@@ -0,0 +1,46 @@
+#include "futex.hpp"
+
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex word must be a plain 32-bit integer");
+
+void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected) {
+    // EAGAIN (value already changed) and EINTR are both just early returns;
+    // callers always re-check their condition.
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+
+uint32_t WaitSignal::prepare_wait() {
+    // seq_cst RMW: orders setting the waiter bit before the caller's re-check
+    // of the condition, pairing with the fence in notify().
+    return state_.fetch_or(1, std::memory_order_seq_cst) | 1;
+}
+
+void WaitSignal::wait(uint32_t ticket) {
+    while (state_.load(std::memory_order_acquire) == ticket) {
+        futex_wait(&state_, ticket);
+    }
+}
+
+void WaitSignal::notify() {
+    // Orders the caller's publish (e.g. a ring slot) before reading state_,
+    // so either we see the waiter bit or the waiter sees the published item.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & 1) == 0) return;
+    // state + 1 clears the waiter bit and changes the word, so sleepers with
+    // the old ticket can't miss it. Losing the CAS means another notifier
+    // already woke them.
+    if (state_.compare_exchange_strong(state, state + 1, std::memory_order_release, std::memory_order_relaxed)) {
+        futex_wake(&state_, INT_MAX);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Hints the CPU that we are in a spin-wait loop.
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Sleeps while *addr == expected, or until woken. May return spuriously.
+ */
+void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected);
+
+/**
+ * @brief Wakes up to `count` threads sleeping in futex_wait() on addr.
+ */
+void futex_wake(std::atomic<uint32_t>* addr, int count);
+
+/**
+ * @brief An "event count": lets threads sleep until some condition they
+ * poll lock-free (e.g. "the ring is not empty") may have become true.
+ *
+ * Waiter:
+ *   uint32_t ticket = signal.prepare_wait();
+ *   if (condition()) { signal.cancel_wait(); ... }
+ *   else signal.wait(ticket);
+ *
+ * Notifier: make the condition true, then call notify().
+ *
+ * The low bit of the futex word means "someone may be sleeping". notify()
+ * clears it and wakes all sleepers, so only the first notify() after a
+ * thread goes to sleep enters the kernel; the rest are a single load.
+ */
+class WaitSignal {
+public:
+    /** @brief Registers as a waiter and returns the ticket to pass to wait(). */
+    uint32_t prepare_wait();
+
+    /** @brief Called instead of wait() when the condition turned out true. */
+    void cancel_wait() {}
+
+    /** @brief Sleeps until notify() is called after prepare_wait() returned ticket. */
+    void wait(uint32_t ticket);
+
+    /** @brief Wakes every waiter, if any thread has called prepare_wait(). */
+    void notify();
+
+private:
+    std::atomic<uint32_t> state_{0};
+};
@@ -0,0 +1,148 @@
+// Microbenchmark: SafeQueue (mutex + condition_variable) vs. RingQueue.
+//
+// Usage: queue_bench [ops_per_producer] [wakeup_samples]
+//
+// 1. Throughput: P producers push, C consumers pop, report ops/sec.
+// 2. Wakeup latency: a consumer blocks on an empty queue; a producer pushes
+//    a timestamp and the consumer records how long it took to return it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock.hpp"
+#include "ring_queue.hpp"
+#include "safe_queue.cpp" // SafeQueue's template definitions live in the .cpp
+
+/**
+ * @brief Runs `producers` x `consumers` threads moving ops_per_producer items each.
+ * @return Millions of items moved per second.
+ */
+template <typename Queue>
+double throughput(Queue& queue, int producers, int consumers, uint64_t ops_per_producer) {
+    uint64_t total = ops_per_producer * producers;
+    std::vector<std::thread> threads;
+    uint64_t start = now_ns();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (uint64_t i = 0; i < ops_per_producer; ++i) queue.push(i);
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        // Split the total so every consumer knows when to stop.
+        uint64_t share = total / consumers + (c < (int)(total % consumers) ? 1 : 0);
+        threads.emplace_back([&queue, share] {
+            uint64_t value;
+            for (uint64_t i = 0; i < share; ++i) queue.wait_and_pop(value);
+        });
+    }
+    for (auto& t : threads) t.join();
+    return total / ((now_ns() - start) / 1.0e9) / 1.0e6;
+}
+
+/**
+ * @brief Same as throughput(), but moving items in batches of `batch` via push_n/pop_n.
+ */
+template <typename Queue>
+double batch_throughput(Queue& queue, int producers, int consumers, uint64_t ops_per_producer, size_t batch) {
+    uint64_t total = ops_per_producer * producers;
+    std::vector<std::thread> threads;
+    uint64_t start = now_ns();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            std::vector<uint64_t> items(batch);
+            for (uint64_t i = 0; i < ops_per_producer; i += batch) {
+                size_t n = std::min<uint64_t>(batch, ops_per_producer - i);
+                queue.push_n(items.begin(), n);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        uint64_t share = total / consumers + (c < (int)(total % consumers) ? 1 : 0);
+        threads.emplace_back([&queue, share, batch] {
+            std::vector<uint64_t> items(batch);
+            uint64_t received = 0;
+            while (received < share) {
+                received += queue.pop_n(items.begin(), std::min<uint64_t>(batch, share - received));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    return total / ((now_ns() - start) / 1.0e9) / 1.0e6;
+}
+
+/**
+ * @brief Ping-pong between two threads; the consumer is usually already
+ * waiting, so this measures push-to-wakeup latency.
+ * @return Sorted latencies in ns.
+ */
+template <typename Queue>
+std::vector<uint64_t> wakeup_latency(Queue& ping, Queue& pong, int samples, uint64_t idle_us) {
+    std::vector<uint64_t> latencies;
+    latencies.reserve(samples);
+    std::thread consumer([&] {
+        uint64_t sent;
+        for (int i = 0; i < samples; ++i) {
+            ping.wait_and_pop(sent);
+            uint64_t latency = now_ns() - sent;
+            pong.push(latency);
+        }
+    });
+    for (int i = 0; i < samples; ++i) {
+        // Give the consumer time to go idle (and, for long gaps, to fall asleep).
+        std::this_thread::sleep_for(std::chrono::microseconds(idle_us));
+        ping.push(now_ns());
+        uint64_t latency;
+        pong.wait_and_pop(latency);
+        latencies.push_back(latency);
+    }
+    consumer.join();
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+static void print_latency(const char* name, uint64_t idle_us, const std::vector<uint64_t>& lat) {
+    auto pct = [&](double p) { return lat[std::min(lat.size() - 1, (size_t)(p / 100.0 * lat.size()))] / 1.0e3; };
+    printf("  %-24s idle=%5luus  p50=%8.2fus  p99=%8.2fus  max=%8.2fus\n",
+           name, (unsigned long)idle_us, pct(50), pct(99), lat.back() / 1.0e3);
+}
+
+int main(int argc, char** argv) {
+    uint64_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    int samples = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const size_t capacity = 1024;
+
+    printf("Throughput (Mops/s), %lu ops per producer:\n", (unsigned long)ops);
+    for (auto [p, c] : std::vector<std::pair<int, int>>{{1, 1}, {2, 2}, {4, 4}}) {
+        SafeQueue<uint64_t> safe;
+        RingQueue<uint64_t> mpmc(capacity);
+        RingQueue<uint64_t> mpmc_batch(capacity);
+        double safe_mops = throughput(safe, p, c, ops);
+        double mpmc_mops = throughput(mpmc, p, c, ops);
+        double batch_mops = batch_throughput(mpmc_batch, p, c, ops, 64);
+        printf("  %dP/%dC  SafeQueue=%7.2f  RingQueue<MPMC>=%7.2f  RingQueue<MPMC> x64 batch=%7.2f",
+               p, c, safe_mops, mpmc_mops, batch_mops);
+        if (p == 1 && c == 1) {
+            RingQueue<uint64_t, SpscRing<uint64_t>> spsc(capacity);
+            RingQueue<uint64_t, SpscRing<uint64_t>> spsc_batch(capacity);
+            printf("  RingQueue<SPSC>=%7.2f  RingQueue<SPSC> x64 batch=%7.2f",
+                   throughput(spsc, 1, 1, ops), batch_throughput(spsc_batch, 1, 1, ops, 64));
+        }
+        printf("\n");
+    }
+
+    printf("Wakeup latency, %d samples:\n", samples);
+    for (uint64_t idle_us : {0ul, 50ul, 1000ul}) {
+        SafeQueue<uint64_t> safe_ping, safe_pong;
+        RingQueue<uint64_t> ring_ping(capacity), ring_pong(capacity);
+        RingQueue<uint64_t, SpscRing<uint64_t>> spsc_ping(capacity), spsc_pong(capacity);
+        print_latency("SafeQueue", idle_us, wakeup_latency(safe_ping, safe_pong, samples, idle_us));
+        print_latency("RingQueue<MPMC>", idle_us, wakeup_latency(ring_ping, ring_pong, samples, idle_us));
+        print_latency("RingQueue<SPSC>", idle_us, wakeup_latency(spsc_ping, spsc_pong, samples, idle_us));
+    }
+    return 0;
+}
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "futex.hpp"
+
+/** @brief Cache line size used to keep producer and consumer indices apart. */
+constexpr size_t RING_CACHE_LINE = 64;
+
+/**
+ * @brief Default number of polls before a blocking call sleeps.
+ *
+ * Spinning only pays off if the thread we are waiting for is running on
+ * another core; on a single-CPU machine it just delays that thread.
+ */
+inline unsigned ring_default_spin_iterations() {
+    static const unsigned spins = std::thread::hardware_concurrency() > 1 ? 2048 : 0;
+    return spins;
+}
+
+/**
+ * @brief Rounds n up to the next power of two (minimum 2).
+ */
+inline size_t ring_capacity_for(size_t n) {
+    size_t cap = 2;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+
+/**
+ * @brief Bounded single-producer / single-consumer ring.
+ *
+ * Exactly one thread may push and exactly one thread may pop. Each side
+ * caches the other side's index, so in steady state a push or pop touches
+ * only its own cache line.
+ *
+ * @tparam T Element type. Must be default-constructible and move-assignable.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(ring_capacity_for(capacity)), mask_(capacity_ - 1),
+          slots_(new T[capacity_]) {}
+
+    template <typename U>
+    bool try_push(U&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == capacity_) return false;
+        }
+        slots_[tail & mask_] = std::forward<U>(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves up to n items from first; publishes them with one index store.
+     * @return Number of items pushed.
+     */
+    template <typename Iter>
+    size_t try_push_n(Iter first, size_t n) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t space = capacity_ - (tail - head_cache_);
+        if (space < n) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            space = capacity_ - (tail - head_cache_);
+        }
+        size_t count = n < space ? n : space;
+        for (size_t i = 0; i < count; ++i, ++first) {
+            slots_[(tail + i) & mask_] = std::move(*first);
+        }
+        if (count) tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool try_pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves up to n items into out; releases the slots with one index store.
+     * @return Number of items popped.
+     */
+    template <typename Iter>
+    size_t try_pop_n(Iter out, size_t n) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t available = tail_cache_ - head;
+        if (available < n) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            available = tail_cache_ - head;
+        }
+        size_t count = n < available ? n : available;
+        for (size_t i = 0; i < count; ++i, ++out) {
+            *out = std::move(slots_[(head + i) & mask_]);
+        }
+        if (count) head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    alignas(RING_CACHE_LINE) std::atomic<size_t> head_{0}; // Written by the consumer
+    size_t tail_cache_ = 0;                                // Consumer's view of tail_
+    alignas(RING_CACHE_LINE) std::atomic<size_t> tail_{0}; // Written by the producer
+    size_t head_cache_ = 0;                                // Producer's view of head_
+};
+
+
+/**
+ * @brief Bounded multi-producer / multi-consumer ring (Vyukov's algorithm).
+ *
+ * Every slot carries a sequence number that says whether it is ready to be
+ * written or read in the current lap, so producers and consumers only
+ * contend on a CAS of their own index and never take a lock.
+ *
+ * @tparam T Element type. Must be default-constructible and move-assignable.
+ */
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : capacity_(ring_capacity_for(capacity)), mask_(capacity_ - 1),
+          slots_(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename U>
+    bool try_push(U&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full: the slot still holds last lap's item
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::forward<U>(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Iter>
+    size_t try_push_n(Iter first, size_t n) {
+        size_t count = 0;
+        while (count < n && try_push(std::move(*first))) {
+            ++count;
+            ++first;
+        }
+        return count;
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Empty: the slot hasn't been written this lap
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(slot->value);
+        slot->sequence.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Iter>
+    size_t try_pop_n(Iter out, size_t n) {
+        size_t count = 0;
+        while (count < n && try_pop(*out)) {
+            ++count;
+            ++out;
+        }
+        return count;
+    }
+
+    /** @brief Approximate under concurrent use. */
+    size_t size() const {
+        size_t enq = enqueue_pos_.load(std::memory_order_acquire);
+        size_t deq = dequeue_pos_.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(RING_CACHE_LINE) std::atomic<size_t> enqueue_pos_{0};
+    alignas(RING_CACHE_LINE) std::atomic<size_t> dequeue_pos_{0};
+};
+
+
+/**
+ * @brief A bounded, lock-free, blocking queue.
+ *
+ * Drop-in for SafeQueue (same push / wait_and_pop / try_pop / empty / size
+ * interface), plus batch push_n / pop_n and a capacity bound: when the ring
+ * is full, push() waits for room instead of growing without limit.
+ *
+ * Blocking calls first spin for a short while (a consumer that is already
+ * running gets the item without a syscall) and only then sleep on a futex.
+ * Producers only enter the kernel for the first push after a consumer
+ * went to sleep; every other wakeup check is a single atomic load.
+ *
+ * @tparam T    The type of element to be stored.
+ * @tparam Ring MpmcRing<T> (default) or SpscRing<T> when there is exactly
+ *              one producer thread and one consumer thread.
+ */
+template <typename T, typename Ring = MpmcRing<T>>
+class RingQueue {
+public:
+    /**
+     * @param capacity        Maximum number of queued items (rounded up to a power of two).
+     * @param spin_iterations How many times blocking calls poll before sleeping.
+     */
+    explicit RingQueue(size_t capacity = 1024, unsigned spin_iterations = ring_default_spin_iterations())
+        : ring_(capacity), spin_iterations_(spin_iterations) {}
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    /** @brief Pushes a copy of value, waiting for room if the queue is full. */
+    void push(const T& value) {
+        T copy(value);
+        push(std::move(copy));
+    }
+
+    /** @brief Moves value into the queue, waiting for room if the queue is full. */
+    void push(T&& value) {
+        wait_until(not_full_, [&] { return ring_.try_push(std::move(value)); });
+        not_empty_.notify();
+    }
+
+    /** @brief Pushes without blocking. @return false if the queue was full. */
+    bool try_push(T&& value) {
+        if (!ring_.try_push(std::move(value))) return false;
+        not_empty_.notify();
+        return true;
+    }
+
+    /**
+     * @brief Moves n items starting at first into the queue, waiting for room as needed.
+     *
+     * Items become visible as they are pushed; consumers are woken once per
+     * batch rather than once per item.
+     */
+    template <typename Iter>
+    void push_n(Iter first, size_t n) {
+        while (n > 0) {
+            size_t pushed = 0;
+            wait_until(not_full_, [&] { return (pushed = ring_.try_push_n(first, n)) > 0; });
+            std::advance(first, pushed);
+            n -= pushed;
+            not_empty_.notify();
+        }
+    }
+
+    /** @brief Waits until an item is available, then pops it by reference. */
+    void wait_and_pop(T& value) {
+        wait_until(not_empty_, [&] { return ring_.try_pop(value); });
+        not_full_.notify();
+    }
+
+    /** @brief Pops without blocking. @return false if the queue was empty. */
+    bool try_pop(T& value) {
+        if (!ring_.try_pop(value)) return false;
+        not_full_.notify();
+        return true;
+    }
+
+    /**
+     * @brief Waits until at least one item is available, then pops up to max_items.
+     * @return Number of items written to out (>= 1).
+     */
+    template <typename Iter>
+    size_t pop_n(Iter out, size_t max_items) {
+        size_t popped = 0;
+        wait_until(not_empty_, [&] { return (popped = ring_.try_pop_n(out, max_items)) > 0; });
+        not_full_.notify();
+        return popped;
+    }
+
+    /** @brief Pops up to max_items without blocking. @return Number popped (may be 0). */
+    template <typename Iter>
+    size_t try_pop_n(Iter out, size_t max_items) {
+        size_t popped = ring_.try_pop_n(out, max_items);
+        if (popped) not_full_.notify();
+        return popped;
+    }
+
+    bool empty() { return ring_.size() == 0; }
+    size_t size() { return ring_.size(); }
+    size_t capacity() const { return ring_.capacity(); }
+
+private:
+    /** @brief Spin-then-futex wait until attempt() succeeds. */
+    template <typename Attempt>
+    void wait_until(WaitSignal& signal, Attempt attempt) {
+        for (unsigned i = 0; i < spin_iterations_; ++i) {
+            if (attempt()) return;
+            cpu_relax();
+        }
+        for (;;) {
+            uint32_t ticket = signal.prepare_wait();
+            if (attempt()) {
+                signal.cancel_wait();
+                return;
+            }
+            signal.wait(ticket);
+            if (attempt()) return;
+        }
+    }
+
+    Ring ring_;
+    unsigned spin_iterations_;
+    WaitSignal not_empty_;
+    WaitSignal not_full_;
+};
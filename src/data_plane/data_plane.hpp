@@ -0,0 +1,230 @@
+#pragma once
+
+// Deterministic test data for the data plane.
+//
+// Every file is a pure function of (seed, size): its bytes are produced in
+// BLOCK_SIZE blocks, each generated independently from the file seed and the
+// block index. Any block can be (re)generated or checked on any thread, so a
+// file is written and verified in parallel, and the same seed always yields
+// the same bytes regardless of thread count.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace data_plane {
+
+/** @brief Unit of generation and checksumming. */
+constexpr uint64_t BLOCK_SIZE = 1024 * 1024;
+
+constexpr const char* MANIFEST_NAME = "manifest.txt";
+constexpr const char* MANIFEST_HEADER = "# hpcfs_bench data plane manifest v1";
+
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+/** @brief Per-file seed: the run seed mixed with the file's relative path. */
+inline uint64_t seed_for(uint64_t run_seed, const std::string& rel_path) {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    for (unsigned char c : rel_path) h = (h ^ c) * 0x100000001b3ull;
+    return splitmix64(run_seed ^ h);
+}
+
+/**
+ * @brief Fills buf with the first len bytes of block `block` of the stream `seed`.
+ *
+ * Counter-mode splitmix64: word j depends only on (seed, block, j), so the
+ * loop has no carried dependency and vectorizes.
+ */
+inline void fill_block(char* buf, size_t len, uint64_t seed, uint64_t block) {
+    uint64_t base = splitmix64(seed ^ splitmix64(block));
+    size_t words = len / 8;
+    uint64_t* out = reinterpret_cast<uint64_t*>(buf); // Callers pass 8-byte aligned buffers
+    for (size_t j = 0; j < words; ++j) out[j] = splitmix64(base + j);
+    if (len % 8) {
+        uint64_t tail = splitmix64(base + words);
+        std::memcpy(buf + words * 8, &tail, len % 8);
+    }
+}
+
+/**
+ * @brief 64-bit checksum of one block. Four independent lanes keep it well
+ * above disk speed; not cryptographic, only meant to catch corruption.
+ */
+inline uint64_t block_checksum(const char* data, size_t len) {
+    const uint64_t k1 = 0x9e3779b185ebca87ull, k2 = 0xc2b2ae3d27d4eb4full;
+    uint64_t lane[4] = {k1, k2, k1 ^ k2, len};
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t w;
+            std::memcpy(&w, data + i + 8 * l, 8);
+            lane[l] = rotl(lane[l] ^ (w * k1), 31) * k2;
+        }
+    }
+    uint64_t h = lane[0] ^ rotl(lane[1], 17) ^ rotl(lane[2], 29) ^ rotl(lane[3], 43);
+    for (; i < len; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ull;
+    return splitmix64(h);
+}
+
+/** @brief Whole-file checksum from its per-block checksums, in order. */
+inline uint64_t combine_checksums(const std::vector<uint64_t>& block_sums, uint64_t file_size) {
+    uint64_t h = splitmix64(file_size);
+    for (uint64_t sum : block_sums) h = splitmix64(h ^ sum);
+    return h;
+}
+
+inline uint64_t num_blocks(uint64_t size) { return (size + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+
+// --- ustar archive of equally sized members ---
+
+/**
+ * @brief Byte layout of a tarball holding `members` files of `member_size`
+ * bytes each, named by member_name(i).
+ *
+ * Every member has the same stride (512-byte header + data padded to 512), so
+ * any byte range of the archive can be produced directly with fill(), and
+ * the archive is generated block by block like any other file.
+ */
+struct TarLayout {
+    uint64_t members = 0;
+    uint64_t member_size = 0;
+    uint64_t run_seed = 0;
+    std::string member_dir;    // Relative dir of the source files (for their seeds)
+    std::string member_prefix; // Member name = member_prefix + index + member_suffix
+    std::string member_suffix;
+    uint64_t first_index = 1;
+
+    uint64_t stride() const { return 512 + (member_size + 511) / 512 * 512; }
+    /** @brief Members plus the two zero blocks that end the archive. */
+    uint64_t size() const { return members * stride() + 1024; }
+
+    std::string member_name(uint64_t i) const {
+        return member_prefix + std::to_string(first_index + i) + member_suffix;
+    }
+
+    void header(uint64_t i, char* out) const {
+        std::memset(out, 0, 512);
+        std::string name = "./" + member_name(i);
+        std::memcpy(out, name.data(), std::min<size_t>(name.size(), 99));
+        std::snprintf(out + 100, 8, "%07o", 0644);
+        std::snprintf(out + 108, 8, "%07o", 0);
+        std::snprintf(out + 116, 8, "%07o", 0);
+        std::snprintf(out + 124, 12, "%011llo", static_cast<unsigned long long>(member_size));
+        std::snprintf(out + 136, 12, "%011o", 0); // Fixed mtime keeps the archive reproducible
+        out[156] = '0';
+        std::memcpy(out + 257, "ustar", 6);
+        std::memcpy(out + 263, "00", 2);
+        std::memset(out + 148, ' ', 8);
+        unsigned sum = 0;
+        for (int b = 0; b < 512; ++b) sum += static_cast<unsigned char>(out[b]);
+        std::snprintf(out + 148, 8, "%06o", sum);
+        out[155] = ' ';
+    }
+
+    /**
+     * @brief Writes archive bytes [offset, offset + len) into buf.
+     * @param scratch At least member_size bytes, 8-byte aligned.
+     */
+    void fill(char* buf, uint64_t offset, size_t len, char* scratch) const {
+        std::memset(buf, 0, len); // Padding and the trailing zero blocks stay zero
+        const uint64_t end = offset + len;
+        char hdr[512];
+        for (uint64_t m = offset / stride(); m < members && m * stride() < end; ++m) {
+            uint64_t start = m * stride();
+            header(m, hdr);
+            uint64_t seed = seed_for(run_seed, member_dir + "/" + member_name(m));
+            fill_block(scratch, member_size, seed, 0);
+            copy_overlap(buf, offset, end, start, hdr, 512);
+            copy_overlap(buf, offset, end, start + 512, scratch, member_size);
+        }
+    }
+
+private:
+    /** @brief Copies the part of [src_start, src_start + n) that falls inside [offset, end). */
+    static void copy_overlap(char* buf, uint64_t offset, uint64_t end,
+                             uint64_t src_start, const char* src, uint64_t n) {
+        uint64_t lo = std::max(offset, src_start);
+        uint64_t hi = std::min(end, src_start + n);
+        if (lo < hi) std::memcpy(buf + (lo - offset), src + (lo - src_start), hi - lo);
+    }
+};
+
+
+// --- Manifest ---
+
+struct ManifestEntry {
+    uint64_t size = 0;
+    uint64_t seed = 0;
+    uint64_t checksum = 0;
+};
+
+/**
+ * @brief Reads "<path> <size> <seed> <checksum>" lines (seed and checksum in hex).
+ * Returns an empty map if the file is missing or from a different version.
+ */
+inline std::map<std::string, ManifestEntry> read_manifest(const std::string& path) {
+    std::map<std::string, ManifestEntry> entries;
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line != MANIFEST_HEADER) return entries;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string rel_path;
+        ManifestEntry entry;
+        if (fields >> rel_path >> entry.size >> std::hex >> entry.seed >> entry.checksum) {
+            entries[rel_path] = entry;
+        }
+    }
+    return entries;
+}
+
+/** @brief fsync()s path (a file, or a directory to persist a rename in it). */
+inline bool fsync_path(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Writes the manifest via a temp file + rename, so a crash never leaves half of one.
+ * The temp file is synced before the rename: otherwise a crash could leave
+ * the new name pointing at an empty or partial manifest.
+ */
+inline bool write_manifest(const std::string& path, const std::map<std::string, ManifestEntry>& entries) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << MANIFEST_HEADER << "\n# path size seed checksum\n";
+        for (const auto& [rel_path, entry] : entries) {
+            out << rel_path << ' ' << std::dec << entry.size << ' '
+                << std::hex << entry.seed << ' ' << entry.checksum << '\n';
+        }
+        if (!out.flush()) return false;
+    }
+    if (!fsync_path(tmp) || std::rename(tmp.c_str(), path.c_str()) != 0) return false;
+    size_t slash = path.find_last_of('/');
+    return fsync_path(slash == std::string::npos ? "." : path.substr(0, slash + 1));
+}
+
+} // namespace data_plane
@@ -0,0 +1,329 @@
+// Generates the data plane (see data_plane_setup.sh) in parallel, from a seed.
+//
+// Usage: data_plane_gen --data-dir DIR [--seed S] [--threads N]
+//                       [--large-size-mb MB] [--small-count N] [--small-size-kb KB]
+//                       [--write-size-mb MB] [--verify]
+//
+// Creates, under DIR:
+//   large_files/file_32G.bin                  one --large-size-mb file
+//   datasets/small_files_text/file_<i>.txt    --small-count files of --small-size-kb
+//   datasets/large_tarball.tar                ustar archive of the small files
+//   manifest.txt                              size, seed and checksum of every file
+//
+// Files whose manifest entry matches the requested size and seed and whose
+// on-disk size is right are reused as is. With --verify they are also read
+// back and checksummed, and regenerated if the checksum doesn't match.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data_plane.hpp"
+#include "../fs_test/aligned_buffer.hpp"
+
+using namespace data_plane;
+
+namespace {
+
+struct Options {
+    std::string data_dir;
+    uint64_t seed = 42;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t large_size = 32ull * 1024 * BLOCK_SIZE;
+    uint64_t small_count = 100000;
+    uint64_t small_size = 4 * 1024;
+    uint64_t write_size = 8 * BLOCK_SIZE;
+    bool verify = false;
+};
+
+/** @brief One file of the data plane and how to produce any range of it. */
+struct FileSpec {
+    std::string rel_path;
+    uint64_t size = 0;
+    uint64_t seed = 0;
+    /** @brief Fills buf with bytes [offset, offset + len); scratch is BLOCK_SIZE bytes. */
+    std::function<void(char* buf, uint64_t offset, size_t len, char* scratch)> fill;
+
+    std::vector<uint64_t> block_sums; // Filled in by write / verify tasks
+    int fd = -1;                      // Shared by every task of a multi-task file
+    bool ok = true;
+};
+
+/**
+ * @brief A unit of work: blocks [block_begin, block_end) of files[file],
+ * or, for small files, the whole of files [file, file + file_count).
+ */
+struct Task {
+    size_t file;
+    size_t file_count;
+    uint64_t block_begin;
+    uint64_t block_end;
+};
+
+/** @brief Splits large files into runs of 8 writes; groups small files 256 to a task. */
+std::vector<Task> make_tasks(const std::vector<FileSpec*>& files, uint64_t write_size) {
+    const uint64_t blocks_per_task = 8 * (write_size / BLOCK_SIZE);
+    const size_t small_files_per_task = 256;
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < files.size();) {
+        uint64_t blocks = num_blocks(files[i]->size);
+        if (blocks > 1) {
+            for (uint64_t b = 0; b < blocks; b += blocks_per_task) {
+                tasks.push_back({i, 1, b, std::min(blocks, b + blocks_per_task)});
+            }
+            ++i;
+            continue;
+        }
+        size_t n = 1;
+        while (n < small_files_per_task && i + n < files.size() && num_blocks(files[i + n]->size) <= 1) ++n;
+        tasks.push_back({i, n, 0, 1});
+        i += n;
+    }
+    return tasks;
+}
+
+/** @brief Runs tasks on `threads` threads, each pulling the next unclaimed one. */
+void run_tasks(const std::vector<Task>& tasks, unsigned threads,
+               const std::function<void(const Task&, AlignedBuffer&, AlignedBuffer&)>& run) {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            AlignedBuffer io;      // One write_size (or BLOCK_SIZE) transfer
+            AlignedBuffer scratch; // BLOCK_SIZE, for generators that need it
+            size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < tasks.size()) run(tasks[i], io, scratch);
+        });
+    }
+    for (auto& t : pool) t.join();
+}
+
+/**
+ * @brief Generates blocks [block_begin, block_end) of one file into its open fd,
+ * in writes of up to io.size() bytes, recording each block's checksum.
+ */
+bool write_blocks(FileSpec& file, uint64_t block_begin, uint64_t block_end, AlignedBuffer& io, char* scratch) {
+    const uint64_t blocks_per_write = io.size() / BLOCK_SIZE;
+    for (uint64_t b = block_begin; b < block_end; b += blocks_per_write) {
+        uint64_t offset = b * BLOCK_SIZE;
+        uint64_t len = std::min(std::min(block_end, b + blocks_per_write) * BLOCK_SIZE, file.size) - offset;
+        file.fill(io.data(), offset, len, scratch);
+        for (uint64_t k = 0; k * BLOCK_SIZE < len; ++k) {
+            uint64_t block_len = std::min<uint64_t>(BLOCK_SIZE, len - k * BLOCK_SIZE);
+            file.block_sums[b + k] = block_checksum(io.data() + k * BLOCK_SIZE, block_len);
+        }
+        if (pwrite(file.fd, io.data(), len, offset) != static_cast<ssize_t>(len)) return false;
+    }
+    return true;
+}
+
+/** @brief Reads blocks back from an open fd and records their checksums. */
+bool read_blocks(FileSpec& file, uint64_t block_begin, uint64_t block_end, AlignedBuffer& io) {
+    const uint64_t blocks_per_read = io.size() / BLOCK_SIZE;
+    for (uint64_t b = block_begin; b < block_end; b += blocks_per_read) {
+        uint64_t offset = b * BLOCK_SIZE;
+        uint64_t len = std::min(std::min(block_end, b + blocks_per_read) * BLOCK_SIZE, file.size) - offset;
+        if (pread(file.fd, io.data(), len, offset) != static_cast<ssize_t>(len)) return false;
+        for (uint64_t k = 0; k * BLOCK_SIZE < len; ++k) {
+            uint64_t block_len = std::min<uint64_t>(BLOCK_SIZE, len - k * BLOCK_SIZE);
+            file.block_sums[b + k] = block_checksum(io.data() + k * BLOCK_SIZE, block_len);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes (or, if `verify`, reads back) every file in parallel and
+ * fills in their block checksums.
+ *
+ * Large files are split across tasks and opened once up front; small files
+ * are created inside their task.
+ */
+bool process(std::vector<FileSpec*>& files, const Options& opt, bool verify) {
+    for (FileSpec* file : files) {
+        file->block_sums.assign(num_blocks(file->size), 0);
+        file->ok = true;
+        if (num_blocks(file->size) <= 1) continue;
+        std::string path = opt.data_dir + "/" + file->rel_path;
+        if (verify) {
+            file->fd = open(path.c_str(), O_RDONLY);
+        } else {
+            // O_DIRECT keeps 32 GB of freshly written data from evicting the
+            // page cache; it needs every write to be a multiple of 4K.
+            int flags = O_CREAT | O_WRONLY | O_TRUNC;
+            bool direct = file->size % 4096 == 0;
+            file->fd = open(path.c_str(), flags | (direct ? O_DIRECT : 0), 0644);
+            if (file->fd < 0 && direct) file->fd = open(path.c_str(), flags, 0644);
+            if (file->fd >= 0 && ftruncate(file->fd, file->size) != 0) {
+                close(file->fd);
+                file->fd = -1;
+            }
+        }
+        if (file->fd < 0) {
+            std::perror(path.c_str());
+            return false;
+        }
+    }
+
+    std::vector<Task> tasks = make_tasks(files, opt.write_size);
+    run_tasks(tasks, opt.threads, [&](const Task& task, AlignedBuffer& io, AlignedBuffer& scratch) {
+        if (!io.data() && !io.allocate(opt.write_size)) std::abort();
+        if (!scratch.data() && !scratch.allocate(BLOCK_SIZE)) std::abort();
+        for (size_t i = task.file; i < task.file + task.file_count; ++i) {
+            FileSpec& file = *files[i];
+            bool whole_file = num_blocks(file.size) <= 1;
+            if (whole_file) {
+                std::string path = opt.data_dir + "/" + file.rel_path;
+                file.fd = verify ? open(path.c_str(), O_RDONLY) : open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+                if (file.fd < 0) { file.ok = false; continue; }
+            }
+            bool ok = verify ? read_blocks(file, task.block_begin, task.block_end, io)
+                             : write_blocks(file, task.block_begin, task.block_end, io, scratch.data());
+            // Multi-block files are fsync()ed once all their tasks are done (below).
+            if (ok && whole_file && !verify && fdatasync(file.fd) != 0) ok = false;
+            if (!ok) file.ok = false; // Only ever set to false, so concurrent tasks can't undo it
+            if (whole_file) {
+                close(file.fd);
+                file.fd = -1;
+            }
+        }
+    });
+
+    bool all_ok = true;
+    for (FileSpec* file : files) {
+        if (file->fd >= 0) {
+            if (!verify && fsync(file->fd) != 0) file->ok = false;
+            close(file->fd);
+            file->fd = -1;
+        }
+        all_ok &= file->ok;
+    }
+    return all_ok;
+}
+
+uint64_t on_disk_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : UINT64_MAX;
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--verify") { opt.verify = true; continue; }
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (flag == "--data-dir") opt.data_dir = value;
+        else if (flag == "--seed") opt.seed = std::stoull(value);
+        else if (flag == "--threads") opt.threads = std::max(1, std::stoi(value));
+        else if (flag == "--large-size-mb") opt.large_size = std::stoull(value) * 1024 * 1024;
+        else if (flag == "--small-count") opt.small_count = std::stoull(value);
+        else if (flag == "--small-size-kb") opt.small_size = std::stoull(value) * 1024;
+        else if (flag == "--write-size-mb") opt.write_size = std::max<uint64_t>(1, std::stoull(value)) * BLOCK_SIZE;
+        else return false;
+    }
+    return !opt.data_dir.empty() && opt.small_size <= BLOCK_SIZE;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "Usage: %s --data-dir DIR [--seed S] [--threads N] [--large-size-mb MB]\n"
+                             "       [--small-count N] [--small-size-kb KB (<= 1024)] [--write-size-mb MB] [--verify]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const std::string small_dir = "datasets/small_files_text";
+    TarLayout tar;
+    tar.members = opt.small_count;
+    tar.member_size = opt.small_size;
+    tar.run_seed = opt.seed;
+    tar.member_dir = small_dir;
+    tar.member_prefix = "file_";
+    tar.member_suffix = ".txt";
+
+    // --- Describe every file ---
+    std::vector<FileSpec> specs;
+    specs.reserve(opt.small_count + 2);
+    auto add_spec = [&](const std::string& rel_path, uint64_t size) -> FileSpec& {
+        specs.push_back({rel_path, size, seed_for(opt.seed, rel_path), nullptr});
+        return specs.back();
+    };
+    FileSpec& large = add_spec("large_files/file_32G.bin", opt.large_size);
+    large.fill = [seed = large.seed](char* buf, uint64_t offset, size_t len, char*) {
+        for (uint64_t done = 0; done < len; done += BLOCK_SIZE) {
+            fill_block(buf + done, std::min<uint64_t>(BLOCK_SIZE, len - done), seed, (offset + done) / BLOCK_SIZE);
+        }
+    };
+    FileSpec& tarball = add_spec("datasets/large_tarball.tar", tar.size());
+    tarball.fill = [&tar](char* buf, uint64_t offset, size_t len, char* scratch) { tar.fill(buf, offset, len, scratch); };
+    for (uint64_t i = 0; i < opt.small_count; ++i) {
+        FileSpec& small = add_spec(small_dir + "/" + tar.member_name(i), opt.small_size);
+        small.fill = [seed = small.seed](char* buf, uint64_t, size_t len, char*) { fill_block(buf, len, seed, 0); };
+    }
+
+    std::filesystem::create_directories(opt.data_dir + "/large_files");
+    std::filesystem::create_directories(opt.data_dir + "/" + small_dir);
+
+    // --- Decide what can be reused ---
+    const std::string manifest_path = opt.data_dir + "/" + MANIFEST_NAME;
+    std::map<std::string, ManifestEntry> manifest = read_manifest(manifest_path);
+    std::vector<FileSpec*> to_write, to_verify;
+    for (FileSpec& spec : specs) {
+        auto it = manifest.find(spec.rel_path);
+        bool reusable = it != manifest.end() && it->second.size == spec.size && it->second.seed == spec.seed
+                     && on_disk_size(opt.data_dir + "/" + spec.rel_path) == spec.size;
+        if (!reusable) to_write.push_back(&spec);
+        else if (opt.verify) to_verify.push_back(&spec);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!to_verify.empty()) {
+        std::printf("Verifying %zu existing file(s)...\n", to_verify.size());
+        process(to_verify, opt, true); // Unreadable files fail their checksum below
+        size_t bad = 0;
+        for (FileSpec* spec : to_verify) {
+            if (!spec->ok || combine_checksums(spec->block_sums, spec->size) != manifest[spec->rel_path].checksum) {
+                std::printf("  checksum mismatch: %s\n", spec->rel_path.c_str());
+                to_write.push_back(spec);
+                ++bad;
+            }
+        }
+        std::printf("  %zu bad, regenerating them.\n", bad);
+    }
+
+    uint64_t bytes = 0;
+    for (FileSpec* spec : to_write) bytes += spec->size;
+    std::printf("Generating %zu file(s), %.2f GiB, on %u thread(s)...\n",
+                to_write.size(), bytes / (1024.0 * 1024.0 * 1024.0), opt.threads);
+    bool ok = process(to_write, opt, false);
+
+    for (FileSpec* spec : to_write) {
+        if (spec->ok) manifest[spec->rel_path] = {spec->size, spec->seed, combine_checksums(spec->block_sums, spec->size)};
+        else manifest.erase(spec->rel_path);
+    }
+    if (!write_manifest(manifest_path, manifest)) {
+        std::perror(manifest_path.c_str());
+        return 1;
+    }
+
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%s in %.2fs (%.2f GiB/s written). %zu file(s) reused.\n",
+                ok ? "Done" : "FAILED", elapsed_s, bytes / (1024.0 * 1024.0 * 1024.0) / std::max(elapsed_s, 1e-9),
+                specs.size() - to_write.size());
+    return ok ? 0 : 1;
+}
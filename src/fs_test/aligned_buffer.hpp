@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdlib>
+#include <utility>
+
+/**
+ * @brief Heap buffer with the alignment O_DIRECT requires.
+ *
+ * std::vector<char> only guarantees alignof(std::max_align_t), which
+ * O_DIRECT rejects with EINVAL on most filesystems.
+ */
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(size_t size, size_t alignment = 4096) { allocate(size, alignment); }
+    ~AlignedBuffer() { clear(); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+    AlignedBuffer(AlignedBuffer&& other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            clear();
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief (Re)allocates the buffer. Contents are uninitialized.
+     * @return false if the allocation failed.
+     */
+    bool allocate(size_t size, size_t alignment = 4096) {
+        clear();
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, alignment, size) != 0) return false;
+        data_ = static_cast<char*>(ptr);
+        size_ = size;
+        return true;
+    }
+
+    void clear() {
+        free(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    char* begin() { return data_; }
+    char* end() { return data_ + size_; }
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
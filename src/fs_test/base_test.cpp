@@ -0,0 +1,9 @@
+#include "base_test.hpp"
+#include "grpc_client_manager.hpp"
+
+std::vector<TestResult> BaseTest::global_execute(
+    GrpcClientManager& grpc_clients,
+    const std::vector<TestContext>& worker_contexts
+) {
+    return grpc_clients.run_all(worker_contexts);
+}
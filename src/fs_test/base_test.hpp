@@ -5,11 +5,10 @@
 #include <map>
 
 // --- Forward Declaration ---
-// Forward-declare your gRPC stub container to avoid including gRPC headers
-// in your main test interface.
-namespace your_project {
-    class GrpcClientManager; // Or whatever your stub container is
-}
+// Forward-declare the gRPC client manager to avoid including gRPC headers
+// in the main test interface. Declared in grpc_client_manager.hpp next to
+// this file, implemented in src/server/grpc_client_manager.cpp.
+class GrpcClientManager;
 
 /**
  * @brief The abstract base class for all distributed filesystem tests.
@@ -41,18 +40,22 @@ public:
      *
      * It implements the test's coordination logic. It is responsible for:
      * 1. Broadcasting worker_setup() to clients.
-     * 2. Broadcasting worker_execute() to clients (sequentially or in parallel).
+     * 2. Broadcasting worker_execute() to clients (sequentially or in parallel;
+     *    GrpcClientManager::broadcast_execute() gives all workers a common start).
      * 3. Waiting for and collecting all TestResult structs.
      * 4. Broadcasting worker_cleanup() to clients.
      *
+     * The default is GrpcClientManager::run_all() over worker_contexts
+     * (setup, synchronized execute, cleanup), which is all most tests need.
+     *
      * @param grpc_clients A manager/list of gRPC clients to communicate with workers.
      * @param worker_contexts (in) The work orders created by global_setup().
      * @return A vector of raw TestResult structs from all workers.
      */
     virtual std::vector<TestResult> global_execute(
-        your_project::GrpcClientManager& grpc_clients,
+        GrpcClientManager& grpc_clients,
         const std::vector<TestContext>& worker_contexts
-    ) = 0;
+    );
 
     /**
      * @brief Runs ONCE on the Server *after* all workers have cleaned up.
@@ -76,7 +79,15 @@ public:
     virtual bool worker_setup(const TestContext& context) = 0;
 
     /**
-     * @brief Runs ONCE on EACH worker. This is the core test logic.
+     * @brief Runs on EACH worker. This is the core test logic.
+     *
+     * Normally once per worker_setup(). With an iteration policy (see
+     * GrpcClientManager::IterationPolicy) the server calls it repeatedly
+     * on the same instance, so state from setup (buffers, open files) is
+     * reused; context.iteration says which call this is. Every call must
+     * therefore measure the same thing: an execute that consumes what setup
+     * prepared (creates names with O_EXCL, unlinks, copies to a fresh
+     * destination) puts it back, untimed, when context.iteration > 0.
      *
      * @param context (in) This worker's specific instructions.
      * @return The raw TestResult for this worker.
@@ -4,6 +4,142 @@
 #include <vector>
 #include <map>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "latency_histogram.hpp"
+
+/**
+ * @brief One timed region of a worker's execution, in absolute time.
+ *
+ * Timestamps are CLOCK_REALTIME nanoseconds. The worker records them on its
+ * own clock; GrpcClientManager shifts them onto the server's clock, so regions
+ * from different workers can be compared directly.
+ */
+struct TimedRegion {
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    /** @brief Bytes moved inside the region, for aggregate bandwidth. */
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Cumulative progress of a running test at one instant (see progress.hpp).
+ */
+struct ProgressSample {
+    uint64_t t_ns = 0; // CLOCK_REALTIME; on the server's clock once corrected
+    uint64_t bytes = 0;
+    uint64_t ops = 0;
+};
+
+/**
+ * @brief One typed result value: an integer, a double, a packed array of
+ * either, or text (for labels such as a pattern name), plus its unit.
+ *
+ * Numbers go into TestResult::metrics as numbers and stay numbers on the
+ * wire (see proto_convert.hpp), so the server aggregates them without
+ * parsing text:
+ *
+ *     result.metrics["write_gbps"] = bytes / GIB / seconds;          // DOUBLE
+ *     result.metrics["files"] = count;                               // INT
+ *     result.metrics["thread_gbps"] = per_thread;                    // vector<double>
+ *     result.metrics["wait_ns"] = Metric(wait_ns).with_unit("ns");
+ *
+ * Without an explicit unit, the one implied by the metric's name suffix
+ * (see metric_unit_for()) applies; it is filled in on receipt rather than
+ * sent with every worker's result.
+ */
+class Metric {
+public:
+    enum class Type : uint8_t { INT, DOUBLE, TEXT, INT_ARRAY, DOUBLE_ARRAY };
+
+    Metric() = default; // Empty text
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    Metric(T value): type_(Type::INT), int_(static_cast<int64_t>(value)) {}
+    template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+    Metric(T value): type_(Type::DOUBLE), double_(static_cast<double>(value)) {}
+    Metric(std::string text): type_(Type::TEXT), text_(std::move(text)) {}
+    Metric(const char* text): type_(Type::TEXT), text_(text) {}
+    Metric(std::vector<int64_t> values): type_(Type::INT_ARRAY), ints_(std::move(values)) {}
+    Metric(std::vector<double> values): type_(Type::DOUBLE_ARRAY), doubles_(std::move(values)) {}
+
+    Metric&& with_unit(std::string unit) && {
+        unit_ = std::move(unit);
+        return std::move(*this);
+    }
+    void set_unit(std::string unit) { unit_ = std::move(unit); }
+
+    Type type() const { return type_; }
+    bool is_number() const { return type_ == Type::INT || type_ == Type::DOUBLE; }
+    const std::string& unit() const { return unit_; }
+
+    /** @brief The value as an integer; doubles are truncated, text is parsed, arrays give 0. */
+    int64_t as_int() const {
+        switch (type_) {
+            case Type::INT: return int_;
+            case Type::DOUBLE: return static_cast<int64_t>(double_);
+            case Type::TEXT: return std::strtoll(text_.c_str(), nullptr, 10);
+            default: return 0;
+        }
+    }
+    /** @brief The value as a double; text is parsed, arrays give 0. */
+    double as_double() const {
+        switch (type_) {
+            case Type::INT: return static_cast<double>(int_);
+            case Type::DOUBLE: return double_;
+            case Type::TEXT: return std::strtod(text_.c_str(), nullptr);
+            default: return 0;
+        }
+    }
+    const std::string& text() const { return text_; }
+    const std::vector<int64_t>& ints() const { return ints_; }
+    const std::vector<double>& doubles() const { return doubles_; }
+
+    /** @brief Text form for humans and text-only stores; arrays are comma-separated. */
+    std::string to_string() const {
+        std::string out;
+        switch (type_) {
+            case Type::INT: return std::to_string(int_);
+            case Type::DOUBLE: return std::to_string(double_);
+            case Type::TEXT: return text_;
+            case Type::INT_ARRAY:
+                for (int64_t v : ints_) out += (out.empty() ? "" : ",") + std::to_string(v);
+                return out;
+            case Type::DOUBLE_ARRAY:
+                for (double v : doubles_) out += (out.empty() ? "" : ",") + std::to_string(v);
+                return out;
+        }
+        return out;
+    }
+
+private:
+    Type type_ = Type::TEXT;
+    int64_t int_ = 0;
+    double double_ = 0;
+    std::string text_;
+    std::vector<int64_t> ints_;
+    std::vector<double> doubles_;
+    std::string unit_;
+};
+
+/**
+ * @brief The unit this repo's metric naming convention implies, e.g.
+ * "GiB/s" for "cold_read_gbps" or "s" for "time_cp_a_s"; "" if none.
+ */
+inline const char* metric_unit_for(const std::string& name) {
+    static const std::pair<const char*, const char*> suffixes[] = {
+        {"_gbps", "GiB/s"}, {"_mib_per_sec", "MiB/s"}, {"_mibps", "MiB/s"},
+        {"_per_sec", "1/s"}, {"_iops", "1/s"},
+        {"_ns", "ns"}, {"_us", "us"}, {"_ms", "ms"}, {"_s", "s"},
+        {"_bytes", "B"}, {"_mb", "MiB"}, {"_pct", "%"},
+    };
+    for (const auto& [suffix, unit] : suffixes) {
+        size_t n = std::char_traits<char>::length(suffix);
+        if (name.size() > n && name.compare(name.size() - n, n, suffix) == 0) return unit;
+    }
+    return "";
+}
 
 /**
  * @brief The raw data container returned by a single worker after executing a test.
@@ -29,14 +165,38 @@ struct TestResult {
     uint64_t duration_ns = 0;
 
     /**
-     * @brief A flexible map for any test-specific raw data.
+     * @brief Named, typed results (see Metric).
      *
      * Examples:
-     * - {"inode": "12345"}
-     * - {"throughput_gbps": "3.14"}
-     * - {"cold_read_s": "10.5", "warm_read_s": "2.1"}
+     * - {"inode": 12345}
+     * - {"throughput_gbps": 3.14}
+     * - {"cold_read_s": 10.5, "warm_read_s": 2.1}
+     * - {"pattern": "zipf"}
+     */
+    std::map<std::string, Metric> metrics;
+
+    /**
+     * @brief Per-operation latency distributions, keyed by operation name.
+     *
+     * Threads should record into their own LatencyHistogram and merge() it
+     * in here after the timed region. Examples: "create", "write", "read".
      */
-    std::map<std::string, std::string> metrics;
+    std::map<std::string, LatencyHistogram> histograms;
+
+    /**
+     * @brief Absolute start/end of the timed regions, keyed by region name.
+     *
+     * The server combines these across workers into true aggregate
+     * bandwidth: total bytes / (last end - first start). Examples:
+     * "sync_write", "cold_read".
+     */
+    std::map<std::string, TimedRegion> regions;
+
+    /**
+     * @brief Progress samples streamed while worker_execute() ran, oldest
+     * first. Filled in by the server; empty unless sampling was requested.
+     */
+    std::vector<ProgressSample> timeline;
 };
 
 /**
@@ -63,4 +223,11 @@ struct TestContext {
      * Examples: {"file_path": "/mnt/hpc-fs/file_0.bin"}, {"file_size_gb": "32"}
      */
     std::map<std::string, std::string> params;
+
+    /**
+     * @brief Which worker_execute() this is since worker_setup(), from 0,
+     * warmup iterations included. Only above 0 when the server repeats
+     * execute (see GrpcClientManager::IterationPolicy).
+     */
+    int iteration = 0;
 };
@@ -1,10 +1,18 @@
 #include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
 
+/**
+ * @brief Checks flock() exclusion between two workers. Lock throughput and
+ * fairness under contention are measured by the lock_contention bench.
+ */
 class FileLockTest: public BaseTest {
 private:
     int locking_test_fd;
     std::filesystem::path g_test_dir;
 public:
+    FileLockTest(const std::string& root) {
+        g_test_dir = root + "/file_lock_test";
+    }
 
     bool global_setup(std::vector<TestContext>& worker_contexts) {
         std::filesystem::create_directory(g_test_dir);
@@ -20,30 +28,22 @@ public:
         std::filesystem::remove_all(g_test_dir);
     }
     std::vector<TestResult> global_execute(
-        // GrpcClientManager& grpc_clients,
+        GrpcClientManager& grpc_clients,
         const std::vector<TestContext>& worker_contexts
     ) {
         // This test MUST be parallel.
-        std::vector<TestResult> results(2);
-
         // 1. Call setup on both workers
-        grpc_clients.rpc_call_setup(0, worker_contexts[0]);
-        grpc_clients.rpc_call_setup(1, worker_contexts[1]);
-
-        // 2. Launch execute calls in parallel
-        auto fut_locker = std::async(std::launch::async, [&]() {
-            return grpc_clients.rpc_call_execute(0, worker_contexts[0]);
-        });
-        auto fut_try_locker = std::async(std::launch::async, [&]() {
-            return grpc_clients.rpc_call_execute(1, worker_contexts[1]);
-        });
+        if (!grpc_clients.broadcast_setup(worker_contexts)) {
+            grpc_clients.broadcast_cleanup(worker_contexts);
+            return std::vector<TestResult>(worker_contexts.size(), TestResult{false, "worker_setup failed"});
+        }
 
-        results[0] = fut_locker.get();
-        results[1] = fut_try_locker.get();
+        // 2. Execute on both workers with a common start time, so the
+        //    try_locker's 1s head start is measured from the same instant.
+        std::vector<TestResult> results = grpc_clients.broadcast_execute(worker_contexts);
 
         // 3. Call cleanup on both workers
-        grpc_clients.rpc_call_cleanup(0, worker_contexts[0]);
-        grpc_clients.rpc_call_cleanup(1, worker_contexts[1]);
+        grpc_clients.broadcast_cleanup(worker_contexts);
         
         return results;
     }
@@ -82,3 +82,7 @@ public:
         return result;
     }
 };
+
+REGISTER_TEST("file_lock", [](const TestContext& config) {
+    return std::make_unique<FileLockTest>(get_param(config, "root", ""));
+});
@@ -1,4 +1,5 @@
 #include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
 
 class HardlinkTest: public BaseTest {
 private:
@@ -28,22 +29,22 @@ public:
         std::filesystem::remove_all(g_test_dir);
     }
     std::vector<TestResult> global_execute(
-        // GrpcClientManager& grpc_clients,
+        GrpcClientManager& grpc_clients,
         const std::vector<TestContext>& worker_contexts
     ) {
         std::vector<TestResult> results(worker_contexts.size());
         
         // This test is sequential. The linker MUST run before the checker.
-        TestResult linker_res = worker_execute(worker_contexts[0]);// grpc_clients.rpc_call_execute(0, worker_contexts[0]);
+        TestResult linker_res = grpc_clients.rpc_call_execute(0, worker_contexts[0]);
         results[0] = linker_res;
         
         if (!linker_res.success) return results; // Stop if link failed
 
         // Pass the inode from the linker to the checker for validation
         TestContext checker_context = worker_contexts[1];
-        checker_context.params["expected_inode"] = linker_res.metrics.at("inode_a");
+        checker_context.params["expected_inode"] = linker_res.metrics.at("inode_a").to_string();
 
-        TestResult checker_res = worker_execute(worker_contexts[1]); //grpc_clients.rpc_call_execute(1, checker_context);
+        TestResult checker_res = grpc_clients.rpc_call_execute(1, checker_context);
         results[1] = checker_res;
         
         return results;
@@ -61,13 +62,13 @@ public:
             TEST_ASSERT(stat(params.at("file_a").c_str(), &st) == 0, "stat(file_a) failed", result);
             ino_t inode_a = st.st_ino;
             TEST_ASSERT(link(params.at("file_a").c_str(), params.at("file_b").c_str()) == 0, "link() failed", result);
-            result.metrics["inode_a"] = std::to_string(inode_a);
+            result.metrics["inode_a"] = inode_a;
             result.success = true;
         } else if (context.role == "checker") {
             struct stat st;
             TEST_ASSERT(stat(params.at("file_b").c_str(), &st) == 0, "stat(file_b) failed", result);
             ino_t inode_b = st.st_ino;
-            result.metrics["inode_b"] = std::to_string(inode_b);
+            result.metrics["inode_b"] = inode_b;
             result.success = true;
         } else if (context.role == "idle") {
             result.success = true;
@@ -75,3 +76,7 @@ public:
         return result;
     }
 };
+
+REGISTER_TEST("hardlink", [](const TestContext& config) {
+    return std::make_unique<HardlinkTest>(get_param(config, "root", ""));
+});
@@ -1,11 +1,14 @@
 #include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
 
 class PosixPermissionsTest: public BaseTest {
 private:
     std::string root;
     std::filesystem::path g_test_dir;
 public:
-    PosixPermissionsTest(const std::string& root): root(root) {}
+    PosixPermissionsTest(const std::string& root): root(root) {
+        g_test_dir = root + "/posix_permissions_test";
+    }
 
     bool global_setup(std::vector<TestContext>& worker_contexts) {
         std::filesystem::create_directory(g_test_dir);
@@ -21,7 +24,7 @@ public:
         std::filesystem::remove_all(g_test_dir);
     }
     std::vector<TestResult> global_execute(
-        // GrpcClientManager& grpc_clients,
+        GrpcClientManager& grpc_clients,
         const std::vector<TestContext>& worker_contexts
     ) {
         std::vector<TestResult> results;
@@ -32,22 +35,22 @@ public:
 
         // Step 1: Owner creates file 0600
         owner_ctx.params["step"] = "create_600";
-        results.push_back(worker_execute(owner_ctx));// grpc_clients.rpc_call_execute(0, owner_ctx));
+        results.push_back(grpc_clients.rpc_call_execute(0, owner_ctx));
         if (!results.back().success) return results;
 
         // Step 2: Other user tries to read (should fail)
         other_ctx.params["step"] = "check_fail_read";
-        results.push_back(worker_execute(other_ctx));//grpc_clients.rpc_call_execute(1, other_ctx));
+        results.push_back(grpc_clients.rpc_call_execute(1, other_ctx));
         if (!results.back().success) return results;
 
         // Step 3: Owner changes perms to 0644
         owner_ctx.params["step"] = "chmod_644";
-        results.push_back(worker_execute(owner_ctx));//grpc_clients.rpc_call_execute(0, owner_ctx));
+        results.push_back(grpc_clients.rpc_call_execute(0, owner_ctx));
         if (!results.back().success) return results;
 
         // Step 4: Other user tries to read (should pass)
         other_ctx.params["step"] = "check_pass_read";
-        results.push_back(worker_execute(other_ctx));//grpc_clients.rpc_call_execute(1, other_ctx));
+        results.push_back(grpc_clients.rpc_call_execute(1, other_ctx));
         
         return results;
     }
@@ -81,3 +84,7 @@ public:
         return result;
     }
 };
+
+REGISTER_TEST("posix_permissions", [](const TestContext& config) {
+    return std::make_unique<PosixPermissionsTest>(get_param(config, "root", ""));
+});
@@ -1,4 +1,5 @@
 #include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
 
 class SymlinkReadTest: public BaseTest {
 private:
@@ -26,14 +27,14 @@ public:
         std::filesystem::remove_all(g_test_dir);
     }
     std::vector<TestResult> global_execute(
-        // GrpcClientManager& grpc_clients,
+        GrpcClientManager& grpc_clients,
         const std::vector<TestContext>& worker_contexts
     ) {
         // Sequential test
-        TestResult linker_res = worker_execute(worker_contexts[0]);// grpc_clients.rpc_call_execute(0, worker_contexts[0]);
+        TestResult linker_res = grpc_clients.rpc_call_execute(0, worker_contexts[0]);
         if (!linker_res.success) return {linker_res};
         
-        TestResult reader_res = worker_execute(worker_contexts[0]);//.rpc_call_execute(1, worker_contexts[1]);
+        TestResult reader_res = grpc_clients.rpc_call_execute(1, worker_contexts[1]);
         return {linker_res, reader_res};
     }
 
@@ -64,4 +65,8 @@ public:
         }
         return result;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_TEST("symlink_read", [](const TestContext& config) {
+    return std::make_unique<SymlinkReadTest>(get_param(config, "root", ""));
+});
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base_test_types.hpp"
+
+class ServerCommunicator;
+
+/**
+ * @brief The server-side handle a BaseTest::global_execute() uses to drive workers.
+ *
+ * Calls are addressed by worker index (TestContext::worker_id), 0 to
+ * num_workers() - 1 over the workers connected when the manager was made;
+ * a worker that disconnected earlier has no index. The broadcast_* calls
+ * queue one request per context on every worker stream before waiting on
+ * any of them, so N workers run a phase concurrently from this one thread;
+ * no thread is spawned per worker. Results are taken as
+ * they arrive (ServerCommunicator::receive_any()), not in context order.
+ * A worker that disconnects, or misses the timeout, gets a failed result
+ * instead of blocking the call.
+ *
+ * Declared here, with the tests that call it, and implemented in
+ * src/server/grpc_client_manager.cpp; this header avoids gRPC and server
+ * includes so fs_test does not depend on src/server.
+ */
+class GrpcClientManager {
+public:
+    /**
+     * @param test_name       Registry name the workers instantiate the test from.
+     * @param min_start_margin_ns Lower bound on how far in the future a
+     *                        synchronized start is scheduled.
+     */
+    GrpcClientManager(std::shared_ptr<ServerCommunicator> server_communicator,
+                      std::string test_name,
+                      uint64_t min_start_margin_ns = 2000000);
+
+    /** @brief Number of workers connected when the manager was made. */
+    size_t num_workers() const { return slots_.size(); }
+
+    // --- Single-worker calls (block until that worker answers) ---
+
+    bool rpc_call_setup(size_t worker, const TestContext& context);
+    TestResult rpc_call_execute(size_t worker, const TestContext& context);
+    void rpc_call_cleanup(size_t worker, const TestContext& context);
+
+    // --- Fan-out calls: worker_contexts[i] goes to worker worker_contexts[i].worker_id ---
+
+    /** @return true if every worker's worker_setup() succeeded. */
+    bool broadcast_setup(const std::vector<TestContext>& worker_contexts);
+
+    /**
+     * @brief Runs worker_execute() on every worker with a synchronized start.
+     *
+     * Two phases: ARM confirms every worker is set up and measures how long
+     * one fan-out round trip takes; GO then sends EXECUTE with a common
+     * start_at_ns that far (at least min_start_margin_ns) in the future.
+     * Each worker sleeps, then spins, until start_at_ns before entering its
+     * timed section, so start times line up regardless of the order in which
+     * the GO messages arrive. Each result carries "start_late_ns", how late
+     * that worker actually started.
+     *
+     * start_at_ns is translated to each worker's clock, and the TimedRegions
+     * in the returned results are translated back to the server's, so regions
+     * from different workers share one timeline. Each result also carries
+     * "clock_offset_ns" and "clock_rtt_ns", and, if progress sampling is on,
+     * the worker's timeline.
+     *
+     * @return One TestResult per context, in context order.
+     */
+    std::vector<TestResult> broadcast_execute(const std::vector<TestContext>& worker_contexts);
+
+    void broadcast_cleanup(const std::vector<TestContext>& worker_contexts);
+
+    /** @brief A worker's clock relative to the server's. */
+    struct ClockOffset {
+        int64_t offset_ns = 0; // worker clock - server clock
+        uint64_t rtt_ns = 0;   // Round trip of the probe the estimate came from
+    };
+
+    /**
+     * @brief Estimates each worker's clock offset with `rounds` NTP-style probes.
+     *
+     * Probes are fanned out like any other phase, one round at a time, and
+     * the sample with the shortest round trip wins: its offset error is at
+     * most rtt/2. broadcast_execute() calls this itself the first time it
+     * sees a worker.
+     */
+    void sync_clocks(const std::vector<TestContext>& worker_contexts, unsigned rounds = 8);
+
+    /**
+     * @brief Asks workers to stream progress samples every interval_ms while
+     * they execute (0 = off, the default). A "progress_interval_ms" param in
+     * a worker's context overrides this for that worker.
+     *
+     * The samples end up in TestResult::timeline, on the server's clock.
+     */
+    void set_progress_interval_ms(uint32_t interval_ms) { progress_interval_ms_ = interval_ms; }
+
+    /**
+     * @brief Longest any one call waits for its results (0 = no limit, the
+     * default: wait as long as the workers stay connected). Workers still
+     * missing then get a failed result.
+     */
+    void set_timeout_s(double timeout_s) { timeout_ns_ = static_cast<uint64_t>(timeout_s * 1e9); }
+
+    /** @brief Called with (worker index, result) for every execute result, as it arrives. */
+    using ResultCallback = std::function<void(size_t worker, const TestResult& result)>;
+
+    /**
+     * @brief Sets the callback broadcast_execute() and rpc_call_execute() run
+     * for each result the moment it is received, already on the server's
+     * clock, from the calling thread.
+     */
+    void set_execute_callback(ResultCallback callback) { execute_callback_ = std::move(callback); }
+
+    /**
+     * @brief Repeat-until-converged execution for run_all().
+     *
+     * Between one setup and one cleanup, the workers' test instance (and
+     * everything worker_setup() allocated) stays alive while execute runs
+     * `warmup` untimed iterations, then measured ones until the 95%
+     * confidence interval of the primary metric is within target_rel_ci of
+     * its mean (after at least min_iterations), max_iterations is reached,
+     * or budget_s has passed since the first iteration started.
+     *
+     * The primary metric of one iteration is, by `metric`:
+     * - "" (default):   the slowest worker's duration, in seconds;
+     * - "region:NAME":  aggregate GiB/s of region NAME across all workers;
+     * - any other name: that metric summed over all workers.
+     *
+     * run_all() returns the last iteration's results, each with
+     * "iter_metric", "iter_count", "iter_warmup", "iter_mean", "iter_stddev",
+     * "iter_ci95" (half-width), "iter_rel_ci", "iter_converged" (0 or 1) and
+     * "iter_values" (every measured value) added.
+     */
+    struct IterationPolicy {
+        unsigned warmup = 0;
+        unsigned min_iterations = 3;
+        unsigned max_iterations = 1; // 1 with no warmup: a single execute, as without a policy
+        double target_rel_ci = 0.05;
+        double budget_s = 0;         // 0 = no time limit
+        std::string metric;
+
+        /**
+         * @brief defaults, overridden by any of the params "iterations_warmup",
+         * "iterations_min", "iterations_max", "iterations_rel_ci",
+         * "iterations_budget_s" and "iterations_metric".
+         */
+        static IterationPolicy from_params(const std::map<std::string, std::string>& params,
+                                           const IterationPolicy& defaults);
+    };
+
+    /**
+     * @brief Sets the iteration policy run_all() uses (default: execute once).
+     * "iterations_*" params in the first context override it per call.
+     */
+    void set_iteration_policy(const IterationPolicy& policy) { iteration_policy_ = policy; }
+
+    /** @brief Offsets measured so far, by worker index. */
+    const std::map<size_t, ClockOffset>& clock_offsets() const { return clock_offsets_; }
+
+    /**
+     * @brief setup -> synchronized execute -> cleanup on every worker.
+     * Execute is repeated if the iteration policy asks for it.
+     * If setup fails anywhere, execute is skipped and the failing results are returned.
+     */
+    std::vector<TestResult> run_all(const std::vector<TestContext>& worker_contexts);
+
+private:
+    struct Call;
+
+    std::vector<TestResult> broadcast(const std::vector<TestContext>& worker_contexts,
+                                      int phase, uint64_t start_at_ns);
+
+    /** @brief Moves an execute result's regions and timeline onto the server's clock. */
+    void to_server_clock(size_t worker, TestResult& result) const;
+
+    /** @brief The execute loop of run_all() under an iteration policy. */
+    std::vector<TestResult> execute_iterations(const std::vector<TestContext>& worker_contexts,
+                                               const IterationPolicy& policy);
+
+    std::shared_ptr<ServerCommunicator> server_communicator_;
+    std::vector<size_t> slots_; // worker index -> ServerCommunicator slot
+    std::string test_name_;
+    uint64_t min_start_margin_ns_;
+    std::map<size_t, ClockOffset> clock_offsets_;
+    uint32_t progress_interval_ms_ = 0;
+    IterationPolicy iteration_policy_;
+    uint64_t timeout_ns_ = 0;
+    ResultCallback execute_callback_;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+// --- C++ Standard Libs ---
+#include <cstdint>
+#include <algorithm>
+
+// --- C POSIX / Linux Libs ---
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+/**
+ * @brief A minimal io_uring wrapper written directly against the kernel ABI.
+ *
+ * We only need a handful of operations (grab an SQE, submit, reap CQEs),
+ * so this avoids pulling liburing into the build. Like the POSIX calls the
+ * tests already use, methods report failure by returning false / -1 /
+ * nullptr and leave the reason in errno.
+ *
+ * Not thread-safe: one IoUring per submitting thread.
+ */
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring() { close_ring(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief Creates the ring and maps the SQ/CQ rings and the SQE array.
+     *
+     * @param entries Requested submission queue depth (rounded up by the kernel).
+     * @return true on success, false with errno set otherwise.
+     */
+    bool init(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (ring_fd_ < 0) return false;
+
+        sq_map_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_map_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+        }
+
+        sq_map_ = map_region(sq_map_size_, IORING_OFF_SQ_RING);
+        if (!sq_map_) return fail_init();
+        if (single_mmap) {
+            cq_map_ = sq_map_;
+        } else {
+            cq_map_ = map_region(cq_map_size_, IORING_OFF_CQ_RING);
+            if (!cq_map_) return fail_init();
+        }
+        sqes_map_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map_region(sqes_map_size_, IORING_OFF_SQES));
+        if (!sqes_) return fail_init();
+
+        char* sq = static_cast<char*>(sq_map_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_entries_ = p.sq_entries;
+        unsigned* sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        // Identity mapping: SQE slot i is always published at array index i,
+        // so submit() only has to bump the tail.
+        for (unsigned i = 0; i < sq_entries_; ++i) sq_array[i] = i;
+
+        char* cq = static_cast<char*>(cq_map_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        sqe_tail_ = submitted_tail_ = *sq_tail_;
+        return true;
+    }
+
+    /** @brief Unmaps the rings and closes the ring fd. Safe to call twice. */
+    void close_ring() {
+        if (sqes_) munmap(sqes_, sqes_map_size_);
+        if (cq_map_ && cq_map_ != sq_map_) munmap(cq_map_, cq_map_size_);
+        if (sq_map_) munmap(sq_map_, sq_map_size_);
+        if (ring_fd_ >= 0) close(ring_fd_);
+        sqes_ = nullptr;
+        sq_map_ = cq_map_ = nullptr;
+        ring_fd_ = -1;
+    }
+
+    /**
+     * @brief Registers buffers for IORING_OP_{READ,WRITE}_FIXED.
+     * @return true on success, false with errno set otherwise.
+     */
+    bool register_buffers(const iovec* iovecs, unsigned count) {
+        return syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs, count) == 0;
+    }
+
+    /**
+     * @brief Returns a zeroed SQE to fill in, or nullptr if the SQ is full.
+     */
+    io_uring_sqe* get_sqe() {
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sqe_tail_ - head >= sq_entries_) return nullptr;
+        io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+        ++sqe_tail_;
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    /**
+     * @brief Publishes all SQEs obtained since the last submit and enters the kernel.
+     *
+     * @param wait_nr Number of completions to wait for before returning (0 = don't wait).
+     * @return Number of SQEs consumed by the kernel, or -1 with errno set.
+     */
+    int submit(unsigned wait_nr = 0) {
+        unsigned to_submit = sqe_tail_ - submitted_tail_;
+        __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+        submitted_tail_ = sqe_tail_;
+        unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do {
+            ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags, nullptr, 0));
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    /** @brief Returns the next completion without blocking, or nullptr if none. */
+    io_uring_cqe* peek_cqe() {
+        unsigned head = *cq_head_;
+        if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return nullptr;
+        return &cqes_[head & cq_mask_];
+    }
+
+    /** @brief Blocks until a completion is available. Returns nullptr with errno set on error. */
+    io_uring_cqe* wait_cqe() {
+        io_uring_cqe* cqe;
+        while ((cqe = peek_cqe()) == nullptr) {
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret < 0 && errno != EINTR) return nullptr;
+        }
+        return cqe;
+    }
+
+    /** @brief Marks the CQE returned by peek_cqe()/wait_cqe() as consumed. */
+    void cqe_seen() {
+        __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+    }
+
+    unsigned sq_entries() const { return sq_entries_; }
+
+    // --- SQE preparation helpers ---
+
+    static void prep_rw(io_uring_sqe* sqe, uint8_t opcode, int fd, const void* buf,
+                        unsigned len, uint64_t offset, uint64_t user_data) {
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = len;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+    }
+
+    static void prep_write(io_uring_sqe* sqe, int fd, const void* buf, unsigned len,
+                           uint64_t offset, uint64_t user_data) {
+        prep_rw(sqe, IORING_OP_WRITE, fd, buf, len, offset, user_data);
+    }
+
+    static void prep_write_fixed(io_uring_sqe* sqe, int fd, const void* buf, unsigned len,
+                                 uint64_t offset, uint16_t buf_index, uint64_t user_data) {
+        prep_rw(sqe, IORING_OP_WRITE_FIXED, fd, buf, len, offset, user_data);
+        sqe->buf_index = buf_index;
+    }
+
+    static void prep_read(io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                          uint64_t offset, uint64_t user_data) {
+        prep_rw(sqe, IORING_OP_READ, fd, buf, len, offset, user_data);
+    }
+
+private:
+    void* map_region(size_t size, off_t offset) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        return (ptr == MAP_FAILED) ? nullptr : ptr;
+    }
+
+    bool fail_init() {
+        int saved_errno = errno;
+        close_ring();
+        errno = saved_errno;
+        return false;
+    }
+
+    int ring_fd_ = -1;
+
+    void* sq_map_ = nullptr;
+    void* cq_map_ = nullptr;
+    size_t sq_map_size_ = 0;
+    size_t cq_map_size_ = 0;
+    size_t sqes_map_size_ = 0;
+
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;       // Next SQE slot handed out by get_sqe()
+    unsigned submitted_tail_ = 0; // Tail last published to the kernel
+
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief A fixed-size, log-linear (HDR-style) latency histogram.
+ *
+ * Values (nanoseconds) below 2^SUB_BUCKET_BITS are counted exactly. Above
+ * that, every power-of-two range is split into 2^(SUB_BUCKET_BITS-1) equal
+ * sub-buckets, 1/64 of the range wide. Percentiles report a bucket's
+ * midpoint, so they are within 1/128 (< 1%) of the recorded value across
+ * the full uint64_t range.
+ *
+ * All storage is inline, so record() never allocates and is cheap enough to
+ * call once per operation from a hot loop. Give each thread its own histogram
+ * and merge() them once the timed region is over. That storage is ~30 KB,
+ * so structs holding histograms belong on the heap, not the stack.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;       // 128
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;           // 64
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;            // 3776
+
+    /** @brief Records one value (e.g. one operation's latency in ns). */
+    void record(uint64_t value) {
+        counts_[bucket_index(value)]++;
+        count_++;
+        sum_ += value;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    /** @brief Adds all of other's samples to this histogram. */
+    void merge(const LatencyHistogram& other) {
+        if (other.count_ == 0) return;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() {
+        counts_.fill(0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    /**
+     * @brief Returns the value at the given percentile (0-100].
+     *
+     * Reports the midpoint of the bucket holding that rank, so the error is
+     * at most half a bucket (< 1/128 of the value), clamped to the exact
+     * recorded min and max, so p100 == max().
+     */
+    uint64_t percentile(double p) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, count_));
+        if (rank == count_) return max_;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                uint64_t mid = bucket_lower(i) + (bucket_upper(i) - bucket_lower(i)) / 2;
+                return std::max(std::min(mid, max_), min_);
+            }
+        }
+        return max_;
+    }
+
+    // --- Compact encoding ---
+
+    /**
+     * @brief Run-length encodes the bucket counts.
+     *
+     * A positive entry is the count of the next bucket; a negative entry -n
+     * skips n empty buckets. Latency distributions touch a few dozen buckets,
+     * so this is typically tens of varints rather than BUCKET_COUNT entries.
+     */
+    std::vector<int64_t> encode_counts() const {
+        std::vector<int64_t> encoded;
+        int64_t zeros = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            if (counts_[i] == 0) {
+                zeros++;
+                continue;
+            }
+            if (zeros) encoded.push_back(-zeros);
+            zeros = 0;
+            encoded.push_back(static_cast<int64_t>(counts_[i]));
+        }
+        return encoded;
+    }
+
+    /**
+     * @brief Rebuilds a histogram from encode_counts() output plus its summary fields.
+     * @return false if the encoding overruns the bucket array.
+     */
+    template <typename Iter>
+    bool decode_counts(Iter begin, Iter end, uint64_t count, uint64_t sum, uint64_t min, uint64_t max) {
+        reset();
+        size_t index = 0;
+        for (Iter it = begin; it != end; ++it) {
+            int64_t entry = *it;
+            if (entry < 0) {
+                index += static_cast<size_t>(-entry);
+                continue;
+            }
+            if (index >= BUCKET_COUNT) return false;
+            counts_[index++] = static_cast<uint64_t>(entry);
+        }
+        count_ = count;
+        sum_ = sum;
+        min_ = count ? min : UINT64_MAX;
+        max_ = max;
+        return true;
+    }
+
+    // --- Bucket math ---
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) return static_cast<size_t>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BUCKET_BITS + 1;
+        uint64_t top = value >> shift; // in [SUB_BUCKET_HALF, SUB_BUCKET_COUNT)
+        return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + (top - SUB_BUCKET_HALF);
+    }
+
+    static uint64_t bucket_lower(size_t index) {
+        if (index < SUB_BUCKET_COUNT) return index;
+        size_t j = index - SUB_BUCKET_COUNT;
+        int shift = static_cast<int>(j / SUB_BUCKET_HALF) + 1;
+        uint64_t top = SUB_BUCKET_HALF + j % SUB_BUCKET_HALF;
+        return top << shift;
+    }
+
+    static uint64_t bucket_upper(size_t index) {
+        if (index < SUB_BUCKET_COUNT) return index;
+        int shift = static_cast<int>((index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF) + 1;
+        return bucket_lower(index) + ((1ull << shift) - 1);
+    }
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
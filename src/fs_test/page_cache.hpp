@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Per-file page-cache control that needs no root.
+ *
+ * Instead of dropping the whole node's caches through /proc/sys/vm/drop_caches,
+ * a benchmark evicts just the file it is about to read and checks with
+ * mincore() how much of it is actually resident before and after.
+ *
+ * Eviction only covers this node's page cache. Caches behind it (the
+ * filesystem client's own cache, the servers) are untouched; that is what
+ * separates a "warm" read from a "cold" one.
+ */
+namespace page_cache {
+
+struct Residency {
+    uint64_t resident_pages = 0;
+    uint64_t total_pages = 0;
+
+    double fraction() const { return total_pages ? static_cast<double>(resident_pages) / total_pages : 0.0; }
+};
+
+/**
+ * @brief Counts the file's pages in the page cache (mmap + mincore).
+ * Walks the mapping in 1 GiB windows so the mincore vector stays small.
+ */
+inline bool residency(const std::string& path, Residency& out) {
+    out = Residency{};
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    const uint64_t page = sysconf(_SC_PAGESIZE);
+    const uint64_t size = st.st_size;
+    out.total_pages = (size + page - 1) / page;
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const uint64_t window = 1ull << 30;
+    std::vector<unsigned char> vec(window / page);
+    bool ok = true;
+    for (uint64_t offset = 0; offset < size && ok; offset += window) {
+        uint64_t len = std::min(window, size - offset);
+        ok = mincore(static_cast<char*>(map) + offset, len, vec.data()) == 0;
+        uint64_t pages = (len + page - 1) / page;
+        for (uint64_t i = 0; ok && i < pages; ++i) out.resident_pages += vec[i] & 1;
+    }
+    munmap(map, size);
+    return ok;
+}
+
+/**
+ * @brief Drops the file's clean pages from this node's page cache.
+ * Dirty pages can't be dropped, so they are written back first.
+ */
+inline bool evict(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief evict() on every regular file under root, for benchmarks that read
+ * a whole tree. Symlinks are not followed. Dentries and inodes stay cached.
+ */
+inline bool evict_tree(const std::string& root) {
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(root, ec), end;
+    if (ec) return false;
+    for (; it != end; it.increment(ec)) {
+        if (ec) return false;
+        if (!it->is_symlink(ec) && it->is_regular_file(ec) && !evict(it->path().string())) return false;
+    }
+    return !ec;
+}
+
+/**
+ * @brief Pulls the whole file into the page cache with buffered reads.
+ * (POSIX_FADV_WILLNEED is only a hint and returns before the data is in.)
+ */
+inline bool load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<char> buf(1 << 20);
+    ssize_t n;
+    while ((n = read(fd, buf.data(), buf.size())) > 0) {}
+    close(fd);
+    return n == 0;
+}
+
+} // namespace page_cache
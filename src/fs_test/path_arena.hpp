@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Append-only store of NUL-terminated paths in one contiguous buffer.
+ *
+ * Build every path a benchmark will touch before the timed region, then hand
+ * the syscalls a `const char*` from operator[]: the timed loop does no
+ * std::string formatting or allocation, and consecutive paths sit next to
+ * each other in memory.
+ */
+class PathArena {
+public:
+    void reserve(size_t paths, size_t bytes) {
+        offsets_.reserve(paths);
+        buffer_.reserve(bytes);
+    }
+
+    /** @brief Appends prefix + name + '\0'. @return The new path's index. */
+    size_t add(const std::string& prefix, const std::string& name = "") {
+        offsets_.push_back(static_cast<uint32_t>(buffer_.size()));
+        buffer_.insert(buffer_.end(), prefix.begin(), prefix.end());
+        buffer_.insert(buffer_.end(), name.begin(), name.end());
+        buffer_.push_back('\0');
+        return offsets_.size() - 1;
+    }
+
+    /** @brief Only valid until the next add(): the buffer may move. */
+    const char* operator[](size_t index) const { return buffer_.data() + offsets_[index]; }
+
+    size_t size() const { return offsets_.size(); }
+    size_t bytes() const { return buffer_.size(); }
+
+    void clear() {
+        offsets_.clear();
+        buffer_.clear();
+    }
+
+private:
+    std::vector<uint32_t> offsets_;
+    std::vector<char> buffer_;
+};
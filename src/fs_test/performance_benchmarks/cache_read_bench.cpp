@@ -1,49 +1,259 @@
 #include "../test_common.hpp"
+#include "../page_cache.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Read bandwidth of one large file with the page cache cold, warm or hot.
+ *
+ * Cache state is set per file and without root (see page_cache.hpp):
+ * - cold: the file is evicted from this node's page cache before the read.
+ * - warm: the file is read once (untimed, unless an earlier mode already
+ *         read it), then evicted: the local page cache is empty but any
+ *         cache behind it (filesystem client, servers) has just seen the data.
+ * - hot:  the file is fully loaded into the page cache first.
+ * Page-cache residency is measured with mincore() before and after each
+ * read and reported next to the bandwidth, so a mode that didn't get the
+ * cache state it asked for shows up in the results.
+ *
+ * Every worker reads the same file; the server reports the cluster-wide
+ * bandwidth from the workers' "<mode>_read" regions. mmap_io reads the same
+ * file through a mapping instead, for comparison.
+ *
+ * Params:
+ * - num_workers:   server only, workers to run on (default 1).
+ * - file_path
+ * - cache_modes:   comma-separated subset of cold, warm, hot (default all),
+ *                  always run in that order.
+ * - direct:        1 to read with O_DIRECT (default 0). The page cache is
+ *                  then bypassed, so only caches behind it can make a
+ *                  difference between modes.
+ * - read_mode:     "sequential" (default, one thread, read() loop) or
+ *                  "parallel" (file split into byte ranges read with pread()).
+ * - num_threads:   parallel only, reader threads (default 8).
+ * - num_ranges:    parallel only, byte ranges the file is split into
+ *                  (default num_threads). Threads pull ranges until none are left.
+ * - chunk_size_mb: parallel only, size of each pread() (default 1).
+ */
 class CacheReadBench: public BaseTest {
 private:
-    std::vector<char> read_buffer;
+    struct ParallelReadStats {
+        double duration_s = 0;
+        uint64_t total_bytes = 0;
+        std::vector<double> thread_gbps;
+        LatencyHistogram read_latency; // Per pread(), merged across threads
+    };
+
+    static constexpr double GIB = 1024.0 * 1024.0 * 1024.0;
+    static constexpr const char* ALL_MODES[] = {"cold", "warm", "hot"};
+
+    TestContext config;
+
+    std::vector<std::string> cache_modes;
+    int open_flags = O_RDONLY;
+
+    AlignedBuffer read_buffer;
+    std::vector<AlignedBuffer> thread_buffers;
+    bool parallel = false;
+    int num_threads = 1;
+    size_t num_ranges = 1;
+
+    /**
+     * @brief Reads the whole file with a pool of threads, each pulling the next
+     * unread byte range and reading it with chunk-sized pread() calls.
+     */
+    bool time_parallel_read(const std::string& file_path, ParallelReadStats& stats) {
+        int fd = open(file_path.c_str(), open_flags);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { close(fd); return false; }
+
+        const uint64_t file_size = st.st_size;
+        const size_t chunk_size = thread_buffers[0].size();
+        // Ranges are whole chunks so every pread() offset stays O_DIRECT-aligned.
+        uint64_t chunks_total = (file_size + chunk_size - 1) / chunk_size;
+        uint64_t chunks_per_range = std::max<uint64_t>(1, (chunks_total + num_ranges - 1) / num_ranges);
+        uint64_t range_size = chunks_per_range * chunk_size;
+        size_t ranges = (file_size + range_size - 1) / range_size;
+
+        std::atomic<size_t> next_range{0};
+        std::vector<uint64_t> thread_bytes(num_threads, 0);
+        std::vector<uint64_t> thread_ns(num_threads, 0);
+        std::vector<char> thread_ok(num_threads, true); // not vector<bool>: written concurrently
+        std::vector<LatencyHistogram> thread_latency(num_threads);
+
+        auto read_ranges_task = [&](int thread_id) {
+            char* buf = thread_buffers[thread_id].data();
+            LatencyHistogram& latency = thread_latency[thread_id];
+            uint64_t start = now_ns();
+            uint64_t bytes = 0;
+            size_t range;
+            while ((range = next_range.fetch_add(1, std::memory_order_relaxed)) < ranges) {
+                uint64_t offset = range * range_size;
+                uint64_t end = std::min(offset + range_size, file_size);
+                while (offset < end) {
+                    uint64_t op_start = now_ns();
+                    ssize_t n = pread(fd, buf, chunk_size, offset);
+                    if (n <= 0) { thread_ok[thread_id] = false; return; }
+                    latency.record(now_ns() - op_start);
+                    progress_add(n);
+                    offset += n;
+                    bytes += n;
+                }
+            }
+            thread_ns[thread_id] = now_ns() - start;
+            thread_bytes[thread_id] = bytes;
+        };
+
+        std::vector<std::thread> threads;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < num_threads; ++i) {
+            threads.emplace_back(read_ranges_task, i);
+        }
+        for (auto& t : threads) t.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        close(fd);
+
+        stats.duration_s = std::chrono::duration<double>(end - start).count();
+        stats.total_bytes = 0;
+        stats.thread_gbps.clear();
+        stats.read_latency.reset();
+        for (int i = 0; i < num_threads; ++i) {
+            if (!thread_ok[i]) return false;
+            stats.read_latency.merge(thread_latency[i]);
+            stats.total_bytes += thread_bytes[i];
+            double thread_s = thread_ns[i] / 1.0e9;
+            stats.thread_gbps.push_back(thread_s > 0 ? thread_bytes[i] / GIB / thread_s : 0.0);
+        }
+        return stats.total_bytes == file_size;
+    }
+
+    static void report_parallel(TestResult& result, const std::string& prefix, const ParallelReadStats& stats) {
+        auto [min_it, max_it] = std::minmax_element(stats.thread_gbps.begin(), stats.thread_gbps.end());
+        result.metrics[prefix + "_read_gbps"] = stats.total_bytes / GIB / stats.duration_s;
+        result.metrics[prefix + "_thread_gbps"] = stats.thread_gbps;
+        result.metrics[prefix + "_thread_gbps_min"] = *min_it;
+        result.metrics[prefix + "_thread_gbps_max"] = *max_it;
+        result.histograms[prefix + "_read"].merge(stats.read_latency);
+    }
+
 public:
+    explicit CacheReadBench(const TestContext& config): config(config) {}
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        if (!std::filesystem::exists(get_param(config, "file_path", ""))) return false;
+        worker_contexts = make_worker_contexts(config, "reader");
+        return true;
+    }
+    void global_cleanup() {}
+
     bool worker_setup(const TestContext& context) {
-        read_buffer.resize(1 * 1024 * 1024); // 1MB read buffer
+        cache_modes.clear();
+        std::vector<std::string> requested = split(get_param(context, "cache_modes", "cold,warm,hot"));
+        for (const std::string& mode : requested) {
+            if (std::find(std::begin(ALL_MODES), std::end(ALL_MODES), mode) == std::end(ALL_MODES)) return false;
+        }
+        // Run in the canonical order regardless of how they were listed.
+        for (const char* m : ALL_MODES) {
+            if (std::find(requested.begin(), requested.end(), m) != requested.end()) cache_modes.push_back(m);
+        }
+        if (cache_modes.empty()) return false;
+        open_flags = O_RDONLY | (get_param(context, "direct", "0") == "1" ? O_DIRECT : 0);
+
+        parallel = get_param(context, "read_mode", "sequential") == "parallel";
+        if (!parallel) {
+            return read_buffer.allocate(1 * 1024 * 1024); // 1MB read buffer
+        }
+
+        num_threads = std::stoi(get_param(context, "num_threads", "8"));
+        num_ranges = std::stoul(get_param(context, "num_ranges", std::to_string(num_threads)));
+        size_t chunk_size = std::stoul(get_param(context, "chunk_size_mb", "1")) * 1024 * 1024;
+        if (num_threads <= 0 || num_ranges == 0 || chunk_size == 0) return false;
+
+        thread_buffers.clear();
+        thread_buffers.resize(num_threads);
+        for (auto& buffer : thread_buffers) {
+            if (!buffer.allocate(chunk_size)) return false;
+        }
         return true;
     }
     void worker_cleanup(const TestContext& context) {
         read_buffer.clear();
+        thread_buffers.clear();
     }
     TestResult worker_execute(const TestContext& context) {
         TestResult result;
         ScopedTimer timer(result.duration_ns); // Times the *whole* operation
-        const auto& params = context.params;
-        
-        auto time_read = [&](const std::string& file_path) -> double {
-            int fd = open(file_path.c_str(), O_RDONLY | O_DIRECT);
+        std::string file_path = context.params.at("file_path");
+
+        auto time_read = [&](LatencyHistogram& latency, TimedRegion& region_out, uint64_t& bytes) -> double {
+            int fd = open(file_path.c_str(), open_flags);
             if (fd < 0) return -1.0;
-            
+
+            RegionTimer region(region_out);
             auto start = std::chrono::high_resolution_clock::now();
-            while (read(fd, read_buffer.data(), read_buffer.size()) > 0);
+            uint64_t op_start = now_ns();
+            ssize_t n;
+            bytes = 0;
+            while ((n = read(fd, read_buffer.data(), read_buffer.size())) > 0) {
+                uint64_t op_end = now_ns();
+                latency.record(op_end - op_start);
+                progress_add(n);
+                region.add_bytes(n);
+                bytes += n;
+                op_start = op_end;
+            }
             auto end = std::chrono::high_resolution_clock::now();
-            
+
             close(fd);
-            return std::chrono::duration<double>(end - start).count();
+            return n == 0 ? std::chrono::duration<double>(end - start).count() : -1.0;
         };
 
-        std::string file_path = params.at("file_path");
-        long long size_gb = std::stoll(params.at("file_size_gb"));
-
-        // 1. Cold Read
-        system("sudo echo 3 > /proc/sys/vm/drop_caches");
-        double cold_s = time_read(file_path);
-        PERF_TEST_ASSERT(cold_s > 0, "Cold read failed", result);
+        bool file_read = false; // Has this execution read the file yet?
+        for (const std::string& mode : cache_modes) {
+            // Put the page cache in the state this mode is about.
+            if (mode == "warm" && !file_read) {
+                PERF_TEST_ASSERT(page_cache::load(file_path), "Priming read failed", result);
+            }
+            if (mode == "hot") {
+                PERF_TEST_ASSERT(page_cache::load(file_path), "Priming read failed", result);
+            } else {
+                PERF_TEST_ASSERT(page_cache::evict(file_path), "posix_fadvise(DONTNEED) failed", result);
+            }
 
-        // 2. Warm Read
-        system("sudo echo 3 > /proc/sys/vm/drop_caches"); // Clear OS cache *again*
-        double warm_s = time_read(file_path);
-        PERF_TEST_ASSERT(warm_s > 0, "Warm read failed", result);
+            page_cache::Residency before, after;
+            PERF_TEST_ASSERT(page_cache::residency(file_path, before), "mincore() failed", result);
+            if (parallel) {
+                auto stats = std::make_unique<ParallelReadStats>();
+                bool ok;
+                {
+                    RegionTimer region(result.regions[mode + "_read"]);
+                    ok = time_parallel_read(file_path, *stats);
+                    region.add_bytes(stats->total_bytes);
+                }
+                PERF_TEST_ASSERT(ok, mode + " parallel read failed", result);
+                report_parallel(result, mode, *stats);
+            } else {
+                uint64_t bytes = 0;
+                double seconds = time_read(result.histograms[mode + "_read"], result.regions[mode + "_read"], bytes);
+                PERF_TEST_ASSERT(seconds > 0, mode + " read failed", result);
+                result.metrics[mode + "_read_gbps"] = bytes / GIB / seconds;
+            }
+            file_read = true;
+            PERF_TEST_ASSERT(page_cache::residency(file_path, after), "mincore() failed", result);
+            result.metrics[mode + "_residency_before"] = before.fraction();
+            result.metrics[mode + "_residency_after"] = after.fraction();
+        }
 
         result.success = true;
-        result.metrics["cold_read_gbps"] = std::to_string(size_gb / cold_s);
-        result.metrics["warm_read_gbps"] = std::to_string(size_gb / warm_s);
+        if (parallel) result.metrics["num_threads"] = num_threads;
+        result.metrics["direct"] = (open_flags & O_DIRECT) ? 1 : 0;
         return result;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_TEST("cache_read", [](const TestContext& config) {
+    return std::make_unique<CacheReadBench>(config);
+});
@@ -1,7 +1,326 @@
 #include "../test_common.hpp"
+#include "../page_cache.hpp"
+#include "../work_stealing.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <dirent.h>
+#include <memory>
+
+/**
+ * @brief How fast the filesystem ingests a conda environment: many small
+ * files, a deep tree, symlinks and hardlinks.
+ *
+ * The native engine copies the env in-process with a pool of threads, once
+ * per thread count, so the numbers reflect the filesystem rather than
+ * coreutils. `cp -a` and a `tar | tar` pipe are still timed as baselines.
+ *
+ * Before every copy, untimed, its destination is removed and the source env
+ * is evicted from this node's page cache (page_cache::evict_tree), so each
+ * thread count and baseline reads the same cold source.
+ *
+ * Params:
+ * - num_workers:        server only, workers to run on (default 1).
+ * - local_conda_path:   source env; created with `conda create` if missing.
+ * - target_path_native: native copies go to <this>/w<worker>.t<threads>.
+ * - copy_threads:       comma-separated thread counts (default "1,8").
+ * - copy_method:        "auto" (default): copy_file_range, falling back to
+ *                       read/write where the filesystem can't; or
+ *                       "copy_file_range" / "read_write" to force one.
+ * - target_path_cp:     optional, `cp -a` baseline copies to <this>/w<worker>.
+ * - target_path_tar:    optional, `tar | tar` baseline unpacks into <this>/w<worker>.
+ */
 class CondaEnvUploadBench: public BaseTest {
+private:
+    /**
+     * @brief Parallel `cp -a` of a directory tree.
+     *
+     * Tasks (copy a directory's entries, or copy one file) run on a
+     * WorkStealingPool: a directory task lists the directory and queues its
+     * children, so walking and copying share one pool and no thread idles
+     * while any work is left.
+     *
+     * Keeps modes, mtimes, symlinks and hardlinks. Directory modes and times
+     * are applied at the end, children first, so a read-only directory can
+     * still be filled. Hardlinks are created once every file is copied.
+     */
+    class TreeCopier {
+    public:
+        enum class Method { AUTO, COPY_FILE_RANGE, READ_WRITE };
+
+        struct Stats {
+            uint64_t files = 0;
+            uint64_t dirs = 0;
+            uint64_t symlinks = 0;
+            uint64_t hardlinks = 0;
+            uint64_t bytes = 0;
+            uint64_t read_write_fallbacks = 0;
+            LatencyHistogram file_latency; // open to close, per regular file
+        };
+
+        TreeCopier(int num_threads, Method method): num_threads_(num_threads), method_(method), pool_(num_threads) {}
+
+        /** @brief Copies src to dst, which must not exist yet. */
+        bool copy(const std::string& src, const std::string& dst, Stats& total) {
+            std::vector<std::unique_ptr<ThreadState>> states(num_threads_);
+            for (auto& state : states) state = std::make_unique<ThreadState>();
+            bool ok = pool_.run({TaskKind::DIR, src, dst}, [&](int self, const Task& task) {
+                return task.kind == TaskKind::DIR ? copy_dir(self, task, *states[self]) : copy_file(task, *states[self]);
+            });
+            if (!ok) return false;
+
+            for (const auto& [existing, link_path] : deferred_links_) {
+                if (link(existing.c_str(), link_path.c_str()) != 0) return fail("link() failed for " + link_path);
+                total.hardlinks++;
+            }
+
+            // Deepest first: a parent's mode may forbid touching its children.
+            std::vector<DirMeta> dirs;
+            for (auto& state : states) dirs.insert(dirs.end(), state->dirs.begin(), state->dirs.end());
+            std::sort(dirs.begin(), dirs.end(), [](const DirMeta& a, const DirMeta& b) {
+                return a.path.size() > b.path.size();
+            });
+            for (const DirMeta& dir : dirs) {
+                if (chmod(dir.path.c_str(), dir.mode) != 0) return fail("chmod() failed for " + dir.path);
+                utimensat(AT_FDCWD, dir.path.c_str(), dir.times, 0);
+            }
+
+            for (const auto& state : states) {
+                total.files += state->stats.files;
+                total.dirs += state->stats.dirs;
+                total.symlinks += state->stats.symlinks;
+                total.bytes += state->stats.bytes;
+                total.read_write_fallbacks += state->stats.read_write_fallbacks;
+                total.file_latency.merge(state->stats.file_latency);
+            }
+            return true;
+        }
+
+        const std::string& error() const { return error_; }
+
+    private:
+        enum class TaskKind { DIR, FILE };
+
+        struct Task {
+            TaskKind kind;
+            std::string src;
+            std::string dst;
+        };
+
+        struct DirMeta {
+            std::string path;
+            mode_t mode;
+            struct timespec times[2];
+        };
+
+        struct ThreadState {
+            Stats stats;
+            std::vector<DirMeta> dirs;
+            AlignedBuffer buffer; // read/write fallback only
+        };
+
+        static constexpr size_t COPY_CHUNK = 1 << 20;
+
+        bool copy_dir(int self, const Task& task, ThreadState& state) {
+            DIR* dir = opendir(task.src.c_str());
+            if (!dir) return fail("opendir() failed for " + task.src);
+            struct stat st;
+            if (fstat(dirfd(dir), &st) != 0 || mkdir(task.dst.c_str(), 0700) != 0) {
+                closedir(dir);
+                return fail("mkdir() failed for " + task.dst);
+            }
+            state.dirs.push_back({task.dst, st.st_mode & 07777, {st.st_atim, st.st_mtim}});
+            state.stats.dirs++;
+
+            while (struct dirent* entry = readdir(dir)) {
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                std::string src = task.src + "/" + name;
+                std::string dst = task.dst + "/" + name;
+                unsigned char type = entry->d_type;
+                if (type == DT_UNKNOWN) {
+                    struct stat entry_st;
+                    if (fstatat(dirfd(dir), name, &entry_st, AT_SYMLINK_NOFOLLOW) != 0) {
+                        closedir(dir);
+                        return fail("stat() failed for " + src);
+                    }
+                    type = S_ISDIR(entry_st.st_mode) ? DT_DIR : S_ISLNK(entry_st.st_mode) ? DT_LNK :
+                           S_ISREG(entry_st.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+                if (type == DT_DIR) {
+                    pool_.push(self, {TaskKind::DIR, std::move(src), std::move(dst)});
+                } else if (type == DT_REG) {
+                    pool_.push(self, {TaskKind::FILE, std::move(src), std::move(dst)});
+                } else if (type == DT_LNK) {
+                    // Cheap enough to do inline rather than queue.
+                    if (!copy_symlink(src, dst)) {
+                        closedir(dir);
+                        return false;
+                    }
+                    state.stats.symlinks++;
+                }
+                // Sockets, fifos and devices don't occur in conda envs; skipped.
+            }
+            closedir(dir);
+            return true;
+        }
+
+        bool copy_symlink(const std::string& src, const std::string& dst) {
+            char target[PATH_MAX];
+            ssize_t len = readlink(src.c_str(), target, sizeof(target) - 1);
+            if (len < 0) return fail("readlink() failed for " + src);
+            target[len] = '\0';
+            if (symlink(target, dst.c_str()) != 0) return fail("symlink() failed for " + dst);
+            struct stat st;
+            if (lstat(src.c_str(), &st) == 0) {
+                struct timespec times[2] = {st.st_atim, st.st_mtim};
+                utimensat(AT_FDCWD, dst.c_str(), times, AT_SYMLINK_NOFOLLOW);
+            }
+            return true;
+        }
+
+        bool copy_file(const Task& task, ThreadState& state) {
+            uint64_t start = now_ns();
+            int in = open(task.src.c_str(), O_RDONLY);
+            if (in < 0) return fail("open() failed for " + task.src);
+            struct stat st;
+            if (fstat(in, &st) != 0) {
+                close(in);
+                return fail("fstat() failed for " + task.src);
+            }
+            if (st.st_nlink > 1) {
+                // First path of an inode gets the data; the others become links to it.
+                std::lock_guard<std::mutex> lock(links_mtx_);
+                auto [it, first] = inodes_.insert({{st.st_dev, st.st_ino}, task.dst});
+                if (!first) {
+                    deferred_links_.push_back({it->second, task.dst});
+                    close(in);
+                    return true;
+                }
+            }
+
+            int out = open(task.dst.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+            if (out < 0) {
+                close(in);
+                return fail("open() failed for " + task.dst);
+            }
+            bool ok = copy_data(in, out, st.st_size, state);
+            struct timespec times[2] = {st.st_atim, st.st_mtim};
+            ok = ok && fchmod(out, st.st_mode & 07777) == 0 && futimens(out, times) == 0;
+            ok = close(out) == 0 && ok;
+            close(in);
+            if (!ok) return fail("copy failed for " + task.dst);
+
+            state.stats.file_latency.record(now_ns() - start);
+            state.stats.files++;
+            state.stats.bytes += st.st_size;
+            return true;
+        }
+
+        bool copy_data(int in, int out, uint64_t size, ThreadState& state) {
+            uint64_t copied = 0;
+            if (method_ != Method::READ_WRITE && !no_copy_file_range_.load(std::memory_order_relaxed)) {
+                while (copied < size) {
+                    ssize_t n = copy_file_range(in, nullptr, out, nullptr, size - copied, 0);
+                    if (n <= 0) break;
+                    copied += n;
+                    progress_add(n, 0);
+                }
+                if (copied == size) return true;
+                // EXDEV / EOPNOTSUPP / ENOSYS: this filesystem pair can't; stop
+                // trying. Anything else is a real error.
+                if (method_ == Method::COPY_FILE_RANGE ||
+                    (errno != EXDEV && errno != EOPNOTSUPP && errno != ENOSYS && errno != EINVAL)) {
+                    return false;
+                }
+                no_copy_file_range_ = true;
+            }
+            state.stats.read_write_fallbacks += method_ != Method::READ_WRITE;
+            if (!state.buffer.data() && !state.buffer.allocate(COPY_CHUNK)) return false;
+            while (copied < size) {
+                ssize_t n = pread(in, state.buffer.data(), COPY_CHUNK, copied);
+                if (n <= 0) return false;
+                for (ssize_t done = 0; done < n;) {
+                    ssize_t w = pwrite(out, state.buffer.data() + done, n - done, copied + done);
+                    if (w <= 0) return false;
+                    done += w;
+                }
+                copied += n;
+                progress_add(n, 0);
+            }
+            return true;
+        }
+
+        bool fail(const std::string& msg) {
+            std::lock_guard<std::mutex> lock(links_mtx_);
+            if (error_.empty()) error_ = msg + " (errno: " + get_error_str() + ")";
+            return false;
+        }
+
+        const int num_threads_;
+        const Method method_;
+        WorkStealingPool<Task> pool_;
+        std::atomic<bool> no_copy_file_range_{false};
+
+        std::mutex links_mtx_; // Also guards error_
+        std::map<std::pair<dev_t, ino_t>, std::string> inodes_;
+        std::vector<std::pair<std::string, std::string>> deferred_links_; // (existing, new)
+        std::string error_;
+    };
+
+    TestContext config;
+    std::vector<int> thread_counts;
+    TreeCopier::Method method = TreeCopier::Method::AUTO;
+
+    static std::string worker_dir(const std::string& root, const TestContext& context) {
+        return root + "/w" + std::to_string(context.worker_id);
+    }
+    std::string native_dir(const TestContext& context, int threads) const {
+        return context.params.at("target_path_native") + "/w" + std::to_string(context.worker_id) +
+               ".t" + std::to_string(threads);
+    }
+
+    /**
+     * @brief remove_all() that also works on a copy of an env with read-only
+     * directories: each directory is made writable before its entries go.
+     */
+    static void remove_copy(const std::string& dst, std::error_code& ec) {
+        namespace fs = std::filesystem;
+        for (fs::recursive_directory_iterator it(dst, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec) && !it->is_symlink(ec)) {
+                fs::permissions(it->path(), fs::perms::owner_all, fs::perm_options::add, ec);
+            }
+        }
+        if (fs::is_directory(dst)) fs::permissions(dst, fs::perms::owner_all, fs::perm_options::add, ec);
+        ec.clear();
+        fs::remove_all(dst, ec);
+    }
+
+    /**
+     * @brief Untimed reset before one copy: removes dst (recreated empty if
+     * `create`, as `tar -x` needs) and evicts the source from the page cache.
+     * @return An error message, empty on success.
+     */
+    static std::string prepare_copy(const std::string& src, const std::string& dst, bool create) {
+        std::error_code ec;
+        remove_copy(dst, ec);
+        if (!ec && create) std::filesystem::create_directories(dst, ec);
+        if (ec) return "Resetting " + dst + " failed: " + ec.message();
+        if (!page_cache::evict_tree(src)) return "Evicting " + src + " from the page cache failed";
+        return "";
+    }
+
 public:
+    explicit CondaEnvUploadBench(const TestContext& config): config(config) {}
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        if (config.params.count("local_conda_path") == 0 || config.params.count("target_path_native") == 0) return false;
+        worker_contexts = make_worker_contexts(config, "uploader");
+        return true;
+    }
+    void global_cleanup() {}
+
     bool worker_setup(const TestContext& context) {
         const auto& params = context.params;
         std::string local_path = params.at("local_conda_path");
@@ -11,38 +330,118 @@ public:
             std::string cmd = "conda create -p " + local_path + " -y python=3.9 numpy";
             if (system(cmd.c_str()) != 0) return false;
         }
+
+        thread_counts.clear();
+        for (const std::string& count : split(get_param(context, "copy_threads", "1,8"))) {
+            int threads = std::stoi(count);
+            if (threads <= 0) return false;
+            thread_counts.push_back(threads);
+        }
+        std::string method_name = get_param(context, "copy_method", "auto");
+        if (method_name == "auto") method = TreeCopier::Method::AUTO;
+        else if (method_name == "copy_file_range") method = TreeCopier::Method::COPY_FILE_RANGE;
+        else if (method_name == "read_write") method = TreeCopier::Method::READ_WRITE;
+        else return false;
+
+        // Destinations themselves are reset before every copy in worker_execute.
+        std::error_code ec;
+        for (const char* key : {"target_path_native", "target_path_cp", "target_path_tar"}) {
+            if (params.count(key)) std::filesystem::create_directories(params.at(key), ec);
+            if (ec) return false;
+        }
         return true;
     }
     void worker_cleanup(const TestContext& context) {
         // Note: We might want to *keep* the local env to speed up setup next time.
         // system(("rm -rf " + context.params.at("local_conda_path")).c_str());
+        const auto& params = context.params;
+        std::error_code ec;
+        for (int threads : thread_counts) remove_copy(native_dir(context, threads), ec);
+        if (params.count("target_path_cp")) remove_copy(worker_dir(params.at("target_path_cp"), context), ec);
+        if (params.count("target_path_tar")) remove_copy(worker_dir(params.at("target_path_tar"), context), ec);
     }
     TestResult worker_execute(const TestContext& context) {
         TestResult result;
         const auto& params = context.params;
         std::string local_path = params.at("local_conda_path");
-        std::string target_path_cp = params.at("target_path_cp");
-        std::string target_path_tar = params.at("target_path_tar");
+        PERF_TEST_ASSERT(!thread_counts.empty(), "No thread counts (setup failed?)", result);
+
+        uint64_t start_ns = now_ns();
+        uint64_t env_files = 0;
+
+        // 1. Native copy, once per thread count
+        for (int threads : thread_counts) {
+            std::string tag = "native_t" + std::to_string(threads);
+            std::string error = prepare_copy(local_path, native_dir(context, threads), false);
+            PERF_TEST_ASSERT(error.empty(), tag + ": " + error, result);
+            auto stats = std::make_unique<TreeCopier::Stats>();
+            TreeCopier copier(threads, method);
+            uint64_t time_ns;
+            bool ok;
+            {
+                ScopedTimer copy_timer(time_ns);
+                RegionTimer region(result.regions[tag]);
+                ok = copier.copy(local_path, native_dir(context, threads), *stats);
+                region.add_bytes(stats->bytes);
+            }
+            PERF_TEST_ASSERT(ok, tag + ": " + copier.error(), result);
 
-        // 1. Time `cp -a`
-        std::string cmd_cp = "cp -a " + local_path + " " + target_path_cp;
-        uint64_t time_cp_ns;
-        {
-            ScopedTimer timer(time_cp_ns);
-            system(cmd_cp.c_str());
+            double time_s = time_ns / 1.0e9;
+            result.metrics[tag + "_s"] = time_s;
+            result.metrics[tag + "_files_per_sec"] = stats->files / time_s;
+            result.metrics[tag + "_mib_per_sec"] = stats->bytes / (1024.0 * 1024.0) / time_s;
+            result.metrics[tag + "_read_write_fallbacks"] = stats->read_write_fallbacks;
+            result.histograms["copy_file_" + tag].merge(stats->file_latency);
+            env_files = stats->files;
+            result.metrics["env_files"] = stats->files;
+            result.metrics["env_dirs"] = stats->dirs;
+            result.metrics["env_symlinks"] = stats->symlinks;
+            result.metrics["env_hardlinks"] = stats->hardlinks;
+            result.metrics["env_bytes"] = stats->bytes;
         }
-        result.metrics["time_cp_a_s"] = std::to_string(time_cp_ns / 1.0e9);
 
-        // 2. Time `tar`
-        std::string cmd_tar = "tar -cf - -C " + local_path + " . | (cd " + target_path_tar + " && tar -xf -)";
-        uint64_t time_tar_ns;
-        {
-            ScopedTimer timer(time_tar_ns);
-            system(cmd_tar.c_str());
+        // 2. Time `cp -a`
+        if (params.count("target_path_cp")) {
+            std::string error = prepare_copy(local_path, worker_dir(params.at("target_path_cp"), context), false);
+            PERF_TEST_ASSERT(error.empty(), "cp -a: " + error, result);
+            std::string cmd_cp = "cp -a " + local_path + " " + worker_dir(params.at("target_path_cp"), context);
+            uint64_t time_cp_ns;
+            int status;
+            {
+                ScopedTimer timer(time_cp_ns);
+                RegionTimer region(result.regions["cp_a"]);
+                status = system(cmd_cp.c_str());
+            }
+            PERF_TEST_ASSERT(status == 0, "cp -a failed", result);
+            result.metrics["time_cp_a_s"] = time_cp_ns / 1.0e9;
+            result.metrics["cp_a_files_per_sec"] = env_files / (time_cp_ns / 1.0e9);
+        }
+
+        // 3. Time `tar`
+        if (params.count("target_path_tar")) {
+            std::string error = prepare_copy(local_path, worker_dir(params.at("target_path_tar"), context), true);
+            PERF_TEST_ASSERT(error.empty(), "tar: " + error, result);
+            std::string cmd_tar = "tar -cf - -C " + local_path + " . | (cd " +
+                                  worker_dir(params.at("target_path_tar"), context) + " && tar -xf -)";
+            uint64_t time_tar_ns;
+            int status;
+            {
+                ScopedTimer timer(time_tar_ns);
+                RegionTimer region(result.regions["tar"]);
+                status = system(cmd_tar.c_str());
+            }
+            PERF_TEST_ASSERT(status == 0, "tar pipe failed", result);
+            result.metrics["time_tar_s"] = time_tar_ns / 1.0e9;
+            result.metrics["tar_files_per_sec"] = env_files / (time_tar_ns / 1.0e9);
         }
-        result.metrics["time_tar_s"] = std::to_string(time_tar_ns / 1.0e9);
 
         result.success = true;
+        result.duration_ns = now_ns() - start_ns;
+        result.metrics["copy_method"] = get_param(context, "copy_method", "auto");
         return result;
     }
-};
\ No newline at end of file
+};
+
+REGISTER_TEST("conda_env_upload", [](const TestContext& config) {
+    return std::make_unique<CondaEnvUploadBench>(config);
+});
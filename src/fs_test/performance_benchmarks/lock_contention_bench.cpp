@@ -0,0 +1,257 @@
+#include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
+#include "../round_merge.hpp"
+
+#include <memory>
+#include <sys/file.h>
+
+/**
+ * @brief Lock/unlock throughput of contenders spread over workers and threads.
+ *
+ * The file_lock correctness test checks flock semantics; this measures what
+ * locking costs when many clients want the same lock, as SQLite and HDF5 do
+ * with fcntl byte-range locks on the shared filesystem.
+ *
+ * Every thread is a contender with its own open file description of one
+ * shared file (flock and OFD locks belong to the description, so threads
+ * sharing an fd would never contend). For duration_s, each contender loops:
+ * take the lock (blocking), hold it for hold_us, release it. The time from
+ * asking to holding is recorded as the wait.
+ *
+ * Lock types:
+ * - flock: flock(LOCK_EX), always the whole file.
+ * - ofd:   fcntl(F_OFD_SETLKW) on range_bytes bytes.
+ * Ranges:
+ * - same:     every contender locks the same range.
+ * - disjoint: contender c locks [c * range_bytes, (c + 1) * range_bytes), so
+ *             nobody conflicts and only the lock manager's own cost is left.
+ *             ofd only: flock has no ranges.
+ *
+ * Each (worker count, lock type, range) combination is a synchronized round
+ * on the first N workers. Per worker, metrics are prefixed
+ * "n<N>_<lock_type>_<range>_": acquisitions, acq_per_sec, the wait_p50_us /
+ * wait_p99_us / wait_p999_us / wait_max_us percentiles, and
+ * thread_acquisitions (one count per thread). The server adds, the same on
+ * every worker of the round:
+ * - cluster_acq_per_sec: all acquisitions over the round's span.
+ * - fairness:            Jain's index over all contenders' acquisition counts,
+ *                        1 when all got the lock equally often, 1/contenders
+ *                        when one got it every time.
+ * - min_max_ratio:       fewest over most acquisitions of any contender.
+ *
+ * Params:
+ * - root:          server only, directory the lock file is created in.
+ * - num_workers:   server only, workers available (default 1).
+ * - worker_counts: server only, comma-separated worker counts to sweep
+ *                  (default num_workers). None may exceed num_workers.
+ * - lock_types:    server only, comma-separated flock and/or ofd (default both).
+ * - ranges:        server only, comma-separated same and/or disjoint (default both).
+ * - num_threads:   contenders per worker (default 4).
+ * - duration_s:    length of each round (default 5).
+ * - hold_us:       time the lock is held before release (default 0).
+ * - range_bytes:   ofd only, bytes per lock (default 4096).
+ */
+class LockContentionBench: public BaseTest {
+private:
+    struct ContenderStats {
+        uint64_t acquisitions = 0;
+        LatencyHistogram wait;
+        bool ok = true;
+        std::string error;
+    };
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::string tag; // n<worker_count>_<lock_type>_<range>
+    bool use_flock = true;
+    bool disjoint = false;
+    int num_threads = 1;
+    uint64_t duration_ns = 0;
+    uint64_t hold_ns = 0;
+    off_t range_bytes = 4096;
+    std::vector<int> fds;
+
+    static void fail(ContenderStats& stats, const std::string& msg) {
+        stats.ok = false;
+        stats.error = msg + " (errno: " + get_error_str() + ")";
+    }
+
+    void run_contender(int fd, int contender, uint64_t deadline, ContenderStats& stats) {
+        struct flock range = {};
+        range.l_whence = SEEK_SET;
+        range.l_start = disjoint ? contender * range_bytes : 0;
+        range.l_len = range_bytes;
+        while (now_ns() < deadline) {
+            uint64_t ask = now_ns();
+            if (use_flock) {
+                if (flock(fd, LOCK_EX) != 0) return fail(stats, "flock(LOCK_EX) failed");
+            } else {
+                range.l_type = F_WRLCK;
+                if (fcntl(fd, F_OFD_SETLKW, &range) != 0) return fail(stats, "fcntl(F_OFD_SETLKW) failed");
+            }
+            uint64_t held = now_ns();
+            stats.wait.record(held - ask);
+            while (hold_ns && now_ns() - held < hold_ns) {}
+            if (use_flock) {
+                if (flock(fd, LOCK_UN) != 0) return fail(stats, "flock(LOCK_UN) failed");
+            } else {
+                range.l_type = F_UNLCK;
+                if (fcntl(fd, F_OFD_SETLK, &range) != 0) return fail(stats, "fcntl(F_UNLCK) failed");
+            }
+            stats.acquisitions++;
+            progress_add(0);
+        }
+    }
+
+    /** @brief Adds the cluster-wide rate and fairness of one round to its workers. */
+    static void summarize_round(std::vector<TestResult>& merged, const std::vector<TestResult>& round,
+                                const std::string& tag) {
+        uint64_t first_start = UINT64_MAX, last_end = 0;
+        std::vector<double> counts;
+        for (const TestResult& r : round) {
+            auto region = r.regions.find(tag);
+            auto per_thread = r.metrics.find(tag + "_thread_acquisitions");
+            if (region == r.regions.end() || per_thread == r.metrics.end()) continue;
+            first_start = std::min(first_start, region->second.start_ns);
+            last_end = std::max(last_end, region->second.end_ns);
+            for (int64_t count : per_thread->second.ints()) counts.push_back(count);
+        }
+        if (counts.empty() || last_end <= first_start) return;
+
+        double sum = 0, sum_sq = 0;
+        for (double c : counts) {
+            sum += c;
+            sum_sq += c * c;
+        }
+        auto [min_it, max_it] = std::minmax_element(counts.begin(), counts.end());
+        std::map<std::string, Metric> summary = {
+            {tag + "_cluster_acq_per_sec", sum / ((last_end - first_start) / 1.0e9)},
+            {tag + "_fairness", sum_sq > 0 ? sum * sum / (counts.size() * sum_sq) : 1.0},
+            {tag + "_min_max_ratio", *max_it > 0 ? *min_it / *max_it : 1.0},
+        };
+        for (size_t w = 0; w < round.size(); ++w) merged[w].metrics.insert(summary.begin(), summary.end());
+    }
+
+public:
+    explicit LockContentionBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/lock_contention_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        std::string lock_file = (g_test_dir / "lock.file").string();
+        int created = open(lock_file.c_str(), O_CREAT | O_WRONLY, 0644);
+        if (created < 0) return false;
+        close(created);
+
+        int num_workers = std::stoi(get_param(config, "num_workers", "1"));
+        for (const std::string& count : split(get_param(config, "worker_counts", std::to_string(num_workers)))) {
+            int n = std::stoi(count);
+            if (n <= 0 || n > num_workers) return false;
+        }
+        worker_contexts = make_worker_contexts(config, "contender");
+        for (TestContext& context : worker_contexts) context.params["lock_file"] = lock_file;
+        return true;
+    }
+    std::vector<TestResult> global_execute(
+        GrpcClientManager& grpc_clients,
+        const std::vector<TestContext>& worker_contexts
+    ) {
+        std::vector<TestResult> merged(worker_contexts.size());
+        std::string counts = get_param(config, "worker_counts", std::to_string(worker_contexts.size()));
+        for (const std::string& count : split(counts)) {
+            for (const std::string& lock_type : split(get_param(config, "lock_types", "flock,ofd"))) {
+                for (const std::string& range : split(get_param(config, "ranges", "same,disjoint"))) {
+                    if (lock_type == "flock" && range == "disjoint") continue; // flock has no ranges
+                    size_t n = std::stoul(count);
+                    std::vector<TestContext> round(worker_contexts.begin(), worker_contexts.begin() + n);
+                    for (TestContext& context : round) {
+                        context.total_workers = static_cast<int>(n);
+                        context.params["worker_count"] = count;
+                        context.params["lock_type"] = lock_type;
+                        context.params["range"] = range;
+                    }
+                    std::string tag = "n" + count + "_" + lock_type + "_" + range;
+                    std::vector<TestResult> results = grpc_clients.run_all(round);
+                    merge_round(merged, results, tag);
+                    summarize_round(merged, results, tag);
+                    bool all_ok = std::all_of(merged.begin(), merged.end(), [](const TestResult& r) { return r.success; });
+                    if (!all_ok) return merged;
+                }
+            }
+        }
+        return merged;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        std::string lock_type = get_param(context, "lock_type", "flock");
+        std::string range = get_param(context, "range", "same");
+        if ((lock_type != "flock" && lock_type != "ofd") || (range != "same" && range != "disjoint")) return false;
+        use_flock = lock_type == "flock";
+        disjoint = range == "disjoint";
+        if (use_flock && disjoint) return false;
+        tag = "n" + get_param(context, "worker_count", std::to_string(context.total_workers)) + "_" + lock_type + "_" + range;
+
+        num_threads = std::stoi(get_param(context, "num_threads", "4"));
+        duration_ns = static_cast<uint64_t>(std::stod(get_param(context, "duration_s", "5")) * 1e9);
+        hold_ns = std::stoull(get_param(context, "hold_us", "0")) * 1000;
+        range_bytes = std::stoll(get_param(context, "range_bytes", "4096"));
+        if (num_threads <= 0 || range_bytes <= 0) return false;
+
+        fds.clear();
+        for (int i = 0; i < num_threads; ++i) {
+            int fd = open(context.params.at("lock_file").c_str(), O_RDWR);
+            if (fd < 0) return false;
+            fds.push_back(fd);
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        for (int fd : fds) close(fd);
+        fds.clear();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        PERF_TEST_ASSERT(static_cast<int>(fds.size()) == num_threads, "Lock file not open (setup failed?)", result);
+
+        std::vector<std::unique_ptr<ContenderStats>> stats(num_threads);
+        for (auto& s : stats) s = std::make_unique<ContenderStats>();
+        {
+            ScopedTimer timer(result.duration_ns);
+            RegionTimer region(result.regions[tag]);
+            uint64_t deadline = now_ns() + duration_ns;
+            std::vector<std::thread> threads;
+            for (int i = 0; i < num_threads; ++i) {
+                int contender = context.worker_id * num_threads + i;
+                threads.emplace_back([&, i, contender] { run_contender(fds[i], contender, deadline, *stats[i]); });
+            }
+            for (auto& t : threads) t.join();
+        }
+
+        LatencyHistogram& wait = result.histograms[tag];
+        std::vector<int64_t> per_thread;
+        for (const auto& s : stats) {
+            PERF_TEST_ASSERT(s->ok, s->error, result);
+            wait.merge(s->wait);
+            per_thread.push_back(s->acquisitions);
+        }
+        double duration_s = result.duration_ns / 1.0e9;
+        result.success = true;
+        result.metrics[tag + "_acquisitions"] = wait.count();
+        result.metrics[tag + "_acq_per_sec"] = wait.count() / duration_s;
+        result.metrics[tag + "_thread_acquisitions"] = per_thread;
+        result.metrics[tag + "_wait_p50_us"] = wait.percentile(50.0) / 1000.0;
+        result.metrics[tag + "_wait_p99_us"] = wait.percentile(99.0) / 1000.0;
+        result.metrics[tag + "_wait_p999_us"] = wait.percentile(99.9) / 1000.0;
+        result.metrics[tag + "_wait_max_us"] = wait.max() / 1000.0;
+        return result;
+    }
+};
+
+REGISTER_TEST("lock_contention", [](const TestContext& config) {
+    return std::make_unique<LockContentionBench>(config);
+});
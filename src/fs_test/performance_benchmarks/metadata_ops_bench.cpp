@@ -1,47 +1,328 @@
 #include "../test_common.hpp"
+#include "../path_arena.hpp"
 
+#include <dirent.h>
+
+/**
+ * @brief mdtest-style metadata benchmark with separately timed phases.
+ *
+ * Every thread owns a private directory tree under test_dir and runs each
+ * selected phase over all of its items. A phase's threads are created
+ * first and released together through a start gate, so thread creation is
+ * not timed; the phase ends when the slowest thread is done.
+ *
+ * Phases, in execution order:
+ * - create:  open(O_CREAT) + close
+ * - stat:    stat()
+ * - open:    open(O_RDONLY) + close
+ * - readdir: opendir + readdir to the end + closedir, one op per directory
+ * - rename:  rename() to a sibling name
+ * - unlink:  unlink()
+ *
+ * Params:
+ * - root:             server only, directory test_dir is created in.
+ * - num_workers:      server only, workers to run on (default 1).
+ * - test_dir, num_threads, files_per_worker
+ * - phases:           comma-separated subset of the above (default all).
+ *                     Without create, the files are created untimed before
+ *                     every execute; with it, a repeated execute (iteration
+ *                     policy) first removes the last one's files, untimed.
+ * - layout:           "flat" (default): files_per_worker / num_threads files
+ *                     in one directory per thread; or "tree": a directory tree
+ *                     of the given depth and branching factor (mdtest -z / -b)
+ *                     with items_per_dir files in every directory (mdtest -I).
+ * - depth:            tree only (default 2).
+ * - branching_factor: tree only (default 4).
+ * - items_per_dir:    tree only (default: files_per_worker / num_threads
+ *                     spread evenly over the tree, at least 1).
+ */
 class MetadataOpsBench: public BaseTest {
-public:
-    bool worker_setup(const TestContext& context) { return true; }
-    void worker_cleanup(const TestContext& context) {}
-    TestResult worker_execute(const TestContext& context) {
-        TestResult result;
-        const auto& params = context.params;
-        int num_threads = std::stoi(params.at("num_threads"));
-        int files_per_worker = std::stoi(params.at("files_per_worker"));
-        int files_per_thread = files_per_worker / num_threads;
-        std::string test_dir = params.at("test_dir");
-        int worker_id = context.worker_id;
+private:
+    /** @brief Paths owned by one thread, built before anything is timed. */
+    struct ThreadPaths {
+        PathArena dirs;    // Parents before children
+        PathArena files;
+        PathArena renamed; // renamed[i] is files[i]'s rename target
+    };
+
+    struct PhaseStats {
+        uint64_t ops = 0;
+        uint64_t duration_ns = 0;
+        LatencyHistogram latency;
+    };
+
+    static constexpr const char* ALL_PHASES[] = {"create", "stat", "open", "readdir", "rename", "unlink"};
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::vector<std::string> phases;
+    std::vector<ThreadPaths> thread_paths;
+    int num_threads = 1;
+
+    bool has_phase(const std::string& phase) const {
+        return std::find(phases.begin(), phases.end(), phase) != phases.end();
+    }
+
+    /**
+     * @brief Adds dir, its files, and (depth > 0) its subtrees to paths.
+     */
+    static void build_tree(ThreadPaths& paths, const std::string& dir, int depth,
+                           int branching_factor, size_t items_per_dir) {
+        paths.dirs.add(dir);
+        for (size_t i = 0; i < items_per_dir; ++i) {
+            std::string name = "/f" + std::to_string(i);
+            paths.files.add(dir, name);
+            paths.renamed.add(dir, name + ".r");
+        }
+        if (depth == 0) return;
+        for (int b = 0; b < branching_factor; ++b) {
+            build_tree(paths, dir + "/d" + std::to_string(b), depth - 1, branching_factor, items_per_dir);
+        }
+    }
+
+    enum class Op { CREATE, STAT, OPEN, READDIR, RENAME, UNLINK };
 
-        auto create_files_task = [=](int thread_id) {
-            for (int i = 0; i < files_per_thread; ++i) {
-                std::string file_path = test_dir + "/file_" + std::to_string(worker_id)
-                                    + "_" + std::to_string(thread_id) + "_" + std::to_string(i);
-                int fd = open(file_path.c_str(), O_CREAT | O_WRONLY, 0644);
+    static Op op_for(const std::string& phase) {
+        if (phase == "create") return Op::CREATE;
+        if (phase == "stat") return Op::STAT;
+        if (phase == "open") return Op::OPEN;
+        if (phase == "readdir") return Op::READDIR;
+        if (phase == "rename") return Op::RENAME;
+        return Op::UNLINK;
+    }
+
+    /**
+     * @brief One timed operation on item i of a thread's paths.
+     * @param renamed Whether the rename phase has moved the files already.
+     * @return false if the syscall failed.
+     */
+    static bool run_op(Op op, const ThreadPaths& paths, size_t i, bool renamed) {
+        switch (op) {
+            case Op::CREATE: {
+                int fd = open(paths.files[i], O_CREAT | O_WRONLY, 0644);
                 if (fd < 0) return false;
                 close(fd);
+                return true;
+            }
+            case Op::STAT: {
+                struct stat st;
+                return stat(paths.files[i], &st) == 0;
+            }
+            case Op::OPEN: {
+                int fd = open(paths.files[i], O_RDONLY);
+                if (fd < 0) return false;
+                close(fd);
+                return true;
+            }
+            case Op::READDIR: {
+                DIR* dir = opendir(paths.dirs[i]);
+                if (!dir) return false;
+                while (readdir(dir) != nullptr) {}
+                closedir(dir);
+                return true;
+            }
+            case Op::RENAME:
+                return rename(paths.files[i], paths.renamed[i]) == 0;
+            case Op::UNLINK:
+                return unlink(renamed ? paths.renamed[i] : paths.files[i]) == 0;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Runs one phase on all threads. readdir works per directory,
+     * every other phase per file. The threads are all started and waiting
+     * before the clock (and region) starts, then released at once.
+     */
+    bool run_phase(const std::string& phase, PhaseStats& stats, TimedRegion& region) {
+        // Resolve everything about the phase once, outside the timed loop.
+        const Op op = op_for(phase);
+        const bool per_dir = (op == Op::READDIR);
+        const bool renamed = has_phase("rename");
+        std::vector<char> thread_ok(num_threads, true);
+        std::vector<LatencyHistogram> thread_latency(num_threads);
+        std::mutex gate_mtx;
+        std::condition_variable gate_cv;
+        int waiting = 0;
+        bool released = false;
+
+        auto phase_task = [&](int thread_id) {
+            {
+                std::unique_lock<std::mutex> lock(gate_mtx);
+                if (++waiting == num_threads) gate_cv.notify_all();
+                gate_cv.wait(lock, [&] { return released; });
+            }
+            const ThreadPaths& paths = thread_paths[thread_id];
+            LatencyHistogram& latency = thread_latency[thread_id];
+            size_t count = per_dir ? paths.dirs.size() : paths.files.size();
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t op_start = now_ns();
+                if (!run_op(op, paths, i, renamed)) { thread_ok[thread_id] = false; return; }
+                latency.record(now_ns() - op_start);
+                progress_add(0);
             }
-            return true;
         };
 
         std::vector<std::thread> threads;
-        std::vector<bool> thread_results(num_threads);
-        
-        ScopedTimer timer(result.duration_ns);
-        for (int i = 0; i < num_threads; ++i) {
-            threads.emplace_back([&, i]() {
-                thread_results[i] = create_files_task(i);
-            });
+        for (int i = 0; i < num_threads; ++i) threads.emplace_back(phase_task, i);
+        uint64_t start;
+        {
+            std::unique_lock<std::mutex> lock(gate_mtx);
+            gate_cv.wait(lock, [&] { return waiting == num_threads; });
+            region.start_ns = realtime_ns();
+            start = now_ns();
+            released = true;
         }
+        gate_cv.notify_all();
         for (auto& t : threads) t.join();
-        // Timer stops here
+        stats.duration_ns = now_ns() - start;
+        region.end_ns = realtime_ns();
+
+        for (int i = 0; i < num_threads; ++i) {
+            if (!thread_ok[i]) return false;
+            stats.latency.merge(thread_latency[i]);
+        }
+        stats.ops = stats.latency.count();
+        return true;
+    }
+
+    /** @brief Makes every thread's directories, parents first. Not timed. */
+    bool make_dirs() {
+        for (const ThreadPaths& paths : thread_paths) {
+            for (size_t i = 0; i < paths.dirs.size(); ++i) {
+                if (mkdir(paths.dirs[i], 0755) != 0 && errno != EEXIST) return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Untimed, before every execute: puts the files where the phases
+     * expect them. Without a create phase they are created here under their
+     * original names (whatever rename or unlink did to them last time); with
+     * one, a repeated execute (`repeat`) first removes the last one's files.
+     */
+    bool prepare_files(bool repeat) const {
+        const bool create = has_phase("create");
+        if (create && !repeat) return true;
+        const bool renames = has_phase("rename");
+        for (const ThreadPaths& paths : thread_paths) {
+            for (size_t i = 0; i < paths.files.size(); ++i) {
+                if (repeat && renames && unlink(paths.renamed[i]) != 0 && errno != ENOENT) return false;
+                if (create) {
+                    if (unlink(paths.files[i]) != 0 && errno != ENOENT) return false;
+                } else {
+                    int fd = open(paths.files[i], O_CREAT | O_WRONLY, 0644);
+                    if (fd < 0) return false;
+                    close(fd);
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    explicit MetadataOpsBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/metadata_ops_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        worker_contexts = make_worker_contexts(config, "default");
+        for (TestContext& context : worker_contexts) context.params["test_dir"] = g_test_dir.string();
+        return true;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        const auto& params = context.params;
+        num_threads = std::stoi(params.at("num_threads"));
+        int files_per_worker = std::stoi(params.at("files_per_worker"));
+        if (num_threads <= 0) return false;
+        size_t files_per_thread = files_per_worker / num_threads;
+
+        phases.clear();
+        for (const std::string& phase : split(get_param(context, "phases", "create,stat,open,readdir,rename,unlink"))) {
+            if (std::find(std::begin(ALL_PHASES), std::end(ALL_PHASES), phase) == std::end(ALL_PHASES)) return false;
+            phases.push_back(phase);
+        }
+        // Run in the canonical order regardless of how they were listed.
+        std::vector<std::string> ordered;
+        for (const char* p : ALL_PHASES) {
+            if (has_phase(p)) ordered.push_back(p);
+        }
+        phases = ordered;
+        if (phases.empty()) return false;
+
+        bool tree = get_param(context, "layout", "flat") == "tree";
+        int depth = tree ? std::stoi(get_param(context, "depth", "2")) : 0;
+        int branching_factor = std::stoi(get_param(context, "branching_factor", "4"));
+        if (depth < 0 || (depth > 0 && branching_factor <= 0)) return false;
+        size_t dirs_per_thread = 1;
+        for (int level = 0, width = 1; level < depth; ++level) {
+            width *= branching_factor;
+            dirs_per_thread += width;
+        }
+        size_t items_per_dir = tree
+            ? std::stoul(get_param(context, "items_per_dir",
+                                   std::to_string(std::max<size_t>(1, files_per_thread / dirs_per_thread))))
+            : files_per_thread;
+
+        std::string test_dir = params.at("test_dir");
+        thread_paths.clear();
+        thread_paths.resize(num_threads);
+        for (int t = 0; t < num_threads; ++t) {
+            ThreadPaths& paths = thread_paths[t];
+            std::string thread_dir = test_dir + "/md." + std::to_string(context.worker_id) + "." + std::to_string(t);
+            size_t files = dirs_per_thread * items_per_dir;
+            size_t path_len = thread_dir.size() + 3 * depth + 16;
+            paths.dirs.reserve(dirs_per_thread, dirs_per_thread * path_len);
+            paths.files.reserve(files, files * path_len);
+            paths.renamed.reserve(files, files * (path_len + 2));
+            build_tree(paths, thread_dir, depth, branching_factor, items_per_dir);
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        // Removes whatever the selected phases left behind.
+        for (const ThreadPaths& paths : thread_paths) {
+            if (paths.dirs.size() > 0) std::filesystem::remove_all(paths.dirs[0]);
+        }
+        thread_paths.clear();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        PERF_TEST_ASSERT(make_dirs(), "mkdir of the test tree failed", result);
+        PERF_TEST_ASSERT(prepare_files(context.iteration > 0), "Preparing the test files failed", result);
+
+        {
+            ScopedTimer timer(result.duration_ns);
+            for (const std::string& phase : phases) {
+                auto stats_ptr = std::make_unique<PhaseStats>();
+                PhaseStats& stats = *stats_ptr;
+                bool ok = run_phase(phase, stats, result.regions[phase]);
+                PERF_TEST_ASSERT(ok, "A thread failed in phase " + phase, result);
+
+                double duration_s = stats.duration_ns / 1.0e9;
+                result.metrics[phase + "_ops"] = stats.ops;
+                result.metrics[phase + "_duration_s"] = duration_s;
+                result.metrics[phase + "_ops_per_sec"] = stats.ops / duration_s;
+                result.histograms[phase].merge(stats.latency);
+            }
+            // Timer stops here
+        }
 
-        for (bool res : thread_results) PERF_TEST_ASSERT(res, "A thread failed to create files", result);
-        
         result.success = true;
-        double duration_s = result.duration_ns / 1.0e9;
-        double iops = static_cast<double>(files_per_worker) / duration_s;
-        result.metrics["local_iops"] = std::to_string(iops);
+        if (has_phase("create")) result.metrics["local_iops"] = result.metrics["create_ops_per_sec"];
+        result.metrics["files_per_thread"] = thread_paths.empty() ? 0 : thread_paths[0].files.size();
+        result.metrics["dirs_per_thread"] = thread_paths.empty() ? 0 : thread_paths[0].dirs.size();
         return result;
     }
 };
+
+REGISTER_TEST("metadata_ops", [](const TestContext& config) {
+    return std::make_unique<MetadataOpsBench>(config);
+});
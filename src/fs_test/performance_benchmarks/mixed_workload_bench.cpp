@@ -0,0 +1,374 @@
+#include "../test_common.hpp"
+#include "../random_dist.hpp"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sstream>
+
+/**
+ * @brief fio-style mixed read/write workload, configured entirely from params.
+ *
+ * Threads issue blocking pread()/pwrite() against a set of files until the
+ * runtime or the byte budget runs out. The access pattern, read/write mix
+ * and block-size distribution are template parameters of the inner loop,
+ * chosen once per run, so the loop carries no per-op branching on config.
+ *
+ * Params:
+ * - num_workers:  server only, workers to run on (default 1).
+ * - file_dir:     directory holding the file set.
+ * - num_files:    files in the set (default 1), named wl.<worker>.<i>, or
+ *                 wl.<i> with shared_files=1 (every worker uses the same files).
+ * - file_size_mb: size of every file (default 1024). Files shorter than this
+ *                 are filled in worker_setup (untimed) unless the run is write-only.
+ * - read_pct:     percentage of ops that are reads, 0-100 (default 100).
+ * - block_size:   one size ("4k") or a weighted distribution
+ *                 ("4k:60,64k:30,1m:10"). Sizes take k/m/g suffixes.
+ * - pattern:      "sequential" (default), "random" or "zipf" offsets.
+ *                 Sequential threads start evenly spread over the file set.
+ * - zipf_theta:   zipf only, skew (default 0.99).
+ * - num_threads:  I/O threads (default 4).
+ * - runtime_s:    stop after this long (default 10; 0 = no time limit).
+ * - size_mb:      stop after each thread moved this much (default 0 = no limit).
+ * - direct:       1 to open with O_DIRECT (default 0); block sizes must then
+ *                 be multiples of 4k.
+ * - keep_files:   1 to leave the file set behind for the next run (default 0).
+ */
+class MixedWorkloadBench: public BaseTest {
+private:
+    enum class Pattern { SEQUENTIAL, RANDOM, ZIPF };
+    enum class Mix { READ_ONLY, WRITE_ONLY, MIXED };
+
+    /** @brief Where the next op goes. */
+    struct Target {
+        size_t file;
+        uint64_t offset;
+    };
+
+    /** @brief Weighted block sizes; a single size skips the draw entirely. */
+    struct BlockSizes {
+        std::vector<size_t> sizes;
+        std::vector<uint64_t> cumulative; // Running weight totals
+        size_t smallest() const { return *std::min_element(sizes.begin(), sizes.end()); }
+        size_t largest() const { return *std::max_element(sizes.begin(), sizes.end()); }
+        size_t pick(FastRng& rng) const {
+            uint64_t r = rng.next() % cumulative.back();
+            size_t i = 0;
+            while (r >= cumulative[i]) ++i;
+            return sizes[i];
+        }
+    };
+
+    struct ThreadStats {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t read_bytes = 0;
+        uint64_t write_bytes = 0;
+        LatencyHistogram read_latency;
+        LatencyHistogram write_latency;
+        bool ok = true;
+        std::string error;
+    };
+
+    // --- Offset generators: one per pattern, each a template argument of run_loop ---
+
+    /** @brief Walks the file set front to back, moving to the next file at the end of one. */
+    struct SequentialOffsets {
+        const MixedWorkloadBench& bench;
+        Target cursor;
+        Target next(FastRng&, size_t bs) {
+            if (cursor.offset + bs > bench.file_size) {
+                cursor.file = (cursor.file + 1) % bench.fds.size();
+                cursor.offset = 0;
+            }
+            Target t = cursor;
+            cursor.offset += bs;
+            return t;
+        }
+    };
+
+    /** @brief Uniform over every bs-aligned slot of the file set. */
+    struct RandomOffsets {
+        const MixedWorkloadBench& bench;
+        Target next(FastRng& rng, size_t bs) {
+            uint64_t slots = bench.file_size / bs;
+            uint64_t slot = rng.next() % (slots * bench.fds.size());
+            return {static_cast<size_t>(slot / slots), (slot % slots) * bs};
+        }
+    };
+
+    /** @brief Zipf over smallest-block-size units of the file set, aligned down to bs. */
+    struct ZipfOffsets {
+        const MixedWorkloadBench& bench;
+        Target next(FastRng& rng, size_t bs) {
+            uint64_t unit = bench.zipf->pick(rng.uniform());
+            uint64_t offset = (unit % bench.units_per_file) * bench.unit_size;
+            offset = std::min(offset / bs * bs, bench.file_size / bs * bs - bs);
+            return {static_cast<size_t>(unit / bench.units_per_file), offset};
+        }
+    };
+
+    TestContext config;
+    std::vector<std::string> paths;
+    std::vector<int> fds;
+    BlockSizes block_sizes;
+    std::unique_ptr<ZipfPicker> zipf;
+    Pattern pattern = Pattern::SEQUENTIAL;
+    Mix mix = Mix::READ_ONLY;
+    uint64_t file_size = 0;
+    uint64_t unit_size = 0;      // smallest block size
+    uint64_t units_per_file = 0;
+    unsigned read_pct = 100;
+    int num_threads = 4;
+    double runtime_s = 10;
+    uint64_t bytes_per_thread = 0;
+    bool keep_files = false;
+
+    static bool parse_block_sizes(const std::string& spec, BlockSizes& out) {
+        out = BlockSizes{};
+        std::stringstream entries(spec);
+        std::string entry;
+        uint64_t total = 0;
+        while (std::getline(entries, entry, ',')) {
+            size_t colon = entry.find(':');
+            uint64_t size = parse_size(entry.substr(0, colon));
+            uint64_t weight = colon == std::string::npos ? 1 : std::stoull(entry.substr(colon + 1));
+            if (size == 0 || weight == 0) return false;
+            total += weight;
+            out.sizes.push_back(size);
+            out.cumulative.push_back(total);
+        }
+        return !out.sizes.empty();
+    }
+
+    /** @brief Makes the file at least file_size long; fills it with data if reads will hit it. */
+    bool prepare_file(const std::string& path) {
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && static_cast<uint64_t>(st.st_size) < file_size) {
+            if (mix == Mix::WRITE_ONLY) {
+                ok = ftruncate(fd, file_size) == 0;
+            } else {
+                std::vector<char> chunk(1 << 20);
+                FastRng rng{file_size ^ std::hash<std::string>()(path)};
+                for (size_t i = 0; i + 8 <= chunk.size(); i += 8) {
+                    uint64_t word = rng.next();
+                    std::memcpy(&chunk[i], &word, 8);
+                }
+                for (uint64_t off = st.st_size; ok && off < file_size; off += chunk.size()) {
+                    size_t len = std::min<uint64_t>(chunk.size(), file_size - off);
+                    ok = pwrite(fd, chunk.data(), len, off) == static_cast<ssize_t>(len);
+                }
+                ok = ok && fdatasync(fd) == 0;
+            }
+        }
+        close(fd);
+        return ok;
+    }
+
+    /**
+     * @brief The timed loop, one instantiation per (pattern, mix, block-size
+     * mode); every branch on those folds away at compile time.
+     */
+    template <typename Offsets, Mix MIX, bool VARIABLE_BS>
+    void run_loop(Offsets offsets, FastRng rng, uint64_t deadline_ns, ThreadStats& stats) {
+        const size_t fixed_bs = block_sizes.sizes[0];
+        AlignedBuffer read_buf(block_sizes.largest());
+        AlignedBuffer write_buf(block_sizes.largest());
+        if (!read_buf.data() || !write_buf.data()) return fail(stats, "buffer allocation failed");
+        for (size_t i = 0; i + 8 <= write_buf.size(); i += 8) {
+            uint64_t word = rng.next();
+            std::memcpy(write_buf.data() + i, &word, 8);
+        }
+
+        for (uint64_t ops = 0;; ++ops) {
+            // Checking the clock every op would cost as much as a cached op.
+            if (deadline_ns && (ops & 63) == 0 && now_ns() >= deadline_ns) break;
+            if (bytes_per_thread && stats.read_bytes + stats.write_bytes >= bytes_per_thread) break;
+
+            const size_t bs = VARIABLE_BS ? block_sizes.pick(rng) : fixed_bs;
+            const Target target = offsets.next(rng, bs);
+            bool is_read;
+            if constexpr (MIX == Mix::READ_ONLY) is_read = true;
+            else if constexpr (MIX == Mix::WRITE_ONLY) is_read = false;
+            else is_read = rng.next() % 100 < read_pct;
+
+            uint64_t op_start = now_ns();
+            if (is_read) {
+                ssize_t n = pread(fds[target.file], read_buf.data(), bs, target.offset);
+                if (n <= 0) return fail(stats, "pread() failed");
+                stats.read_latency.record(now_ns() - op_start);
+                stats.reads++;
+                stats.read_bytes += n;
+                progress_add(n);
+            } else {
+                ssize_t n = pwrite(fds[target.file], write_buf.data(), bs, target.offset);
+                if (n != static_cast<ssize_t>(bs)) return fail(stats, "pwrite() failed");
+                stats.write_latency.record(now_ns() - op_start);
+                stats.writes++;
+                stats.write_bytes += n;
+                progress_add(n);
+            }
+        }
+    }
+
+    template <typename Offsets>
+    void run_with(Offsets offsets, FastRng rng, uint64_t deadline_ns, ThreadStats& stats) {
+        const bool variable_bs = block_sizes.sizes.size() > 1;
+        switch (mix) {
+            case Mix::READ_ONLY:
+                return variable_bs ? run_loop<Offsets, Mix::READ_ONLY, true>(offsets, rng, deadline_ns, stats)
+                                   : run_loop<Offsets, Mix::READ_ONLY, false>(offsets, rng, deadline_ns, stats);
+            case Mix::WRITE_ONLY:
+                return variable_bs ? run_loop<Offsets, Mix::WRITE_ONLY, true>(offsets, rng, deadline_ns, stats)
+                                   : run_loop<Offsets, Mix::WRITE_ONLY, false>(offsets, rng, deadline_ns, stats);
+            case Mix::MIXED:
+                return variable_bs ? run_loop<Offsets, Mix::MIXED, true>(offsets, rng, deadline_ns, stats)
+                                   : run_loop<Offsets, Mix::MIXED, false>(offsets, rng, deadline_ns, stats);
+        }
+    }
+
+    void run_thread(int thread_id, uint64_t deadline_ns, ThreadStats& stats) {
+        FastRng rng{0x9e3779b97f4a7c15ull * (config.worker_id + 1) + 0xbf58476d1ce4e5b9ull * (thread_id + 1)};
+        switch (pattern) {
+            case Pattern::SEQUENTIAL: {
+                // Spread the threads' starting points evenly over the whole set.
+                uint64_t start_unit = units_per_file * fds.size() * thread_id / num_threads;
+                Target start{static_cast<size_t>(start_unit / units_per_file), (start_unit % units_per_file) * unit_size};
+                return run_with(SequentialOffsets{*this, start}, rng, deadline_ns, stats);
+            }
+            case Pattern::RANDOM:
+                return run_with(RandomOffsets{*this}, rng, deadline_ns, stats);
+            case Pattern::ZIPF:
+                return run_with(ZipfOffsets{*this}, rng, deadline_ns, stats);
+        }
+    }
+
+    static void fail(ThreadStats& stats, const std::string& msg) {
+        stats.ok = false;
+        stats.error = msg + " (errno: " + get_error_str() + ")";
+    }
+
+public:
+    explicit MixedWorkloadBench(const TestContext& config): config(config) {}
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        if (!std::filesystem::is_directory(get_param(config, "file_dir", ""))) return false;
+        worker_contexts = make_worker_contexts(config, "default");
+        return true;
+    }
+    void global_cleanup() {}
+
+    bool worker_setup(const TestContext& context) {
+        config = context;
+        std::string file_dir = context.params.at("file_dir");
+        size_t num_files = std::stoul(get_param(context, "num_files", "1"));
+        file_size = std::stoull(get_param(context, "file_size_mb", "1024")) << 20;
+        read_pct = std::stoul(get_param(context, "read_pct", "100"));
+        num_threads = std::stoi(get_param(context, "num_threads", "4"));
+        runtime_s = std::stod(get_param(context, "runtime_s", "10"));
+        bytes_per_thread = std::stoull(get_param(context, "size_mb", "0")) << 20;
+        keep_files = get_param(context, "keep_files", "0") == "1";
+        if (num_files == 0 || read_pct > 100 || num_threads <= 0) return false;
+        if (runtime_s <= 0 && bytes_per_thread == 0) return false; // Would never stop
+        if (!parse_block_sizes(get_param(context, "block_size", "4k"), block_sizes)) return false;
+        if (block_sizes.largest() > file_size) return false;
+        mix = read_pct == 100 ? Mix::READ_ONLY : read_pct == 0 ? Mix::WRITE_ONLY : Mix::MIXED;
+
+        unit_size = block_sizes.smallest();
+        units_per_file = file_size / unit_size;
+        std::string pattern_name = get_param(context, "pattern", "sequential");
+        if (pattern_name == "sequential") {
+            pattern = Pattern::SEQUENTIAL;
+        } else if (pattern_name == "random") {
+            pattern = Pattern::RANDOM;
+        } else if (pattern_name == "zipf") {
+            pattern = Pattern::ZIPF;
+            double theta = std::stod(get_param(context, "zipf_theta", "0.99"));
+            zipf = std::make_unique<ZipfPicker>(units_per_file * num_files, theta, context.worker_id + 1);
+        } else {
+            return false;
+        }
+
+        bool shared = get_param(context, "shared_files", "0") == "1";
+        int flags = (mix == Mix::READ_ONLY ? O_RDONLY : O_RDWR) |
+                    (get_param(context, "direct", "0") == "1" ? O_DIRECT : 0);
+        paths.clear();
+        fds.clear();
+        for (size_t i = 0; i < num_files; ++i) {
+            std::string name = shared ? "/wl." + std::to_string(i)
+                                      : "/wl." + std::to_string(context.worker_id) + "." + std::to_string(i);
+            paths.push_back(file_dir + name);
+            if (!prepare_file(paths.back())) return false;
+            int fd = open(paths.back().c_str(), flags);
+            if (fd < 0) return false;
+            fds.push_back(fd);
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        for (int fd : fds) close(fd);
+        fds.clear();
+        if (!keep_files) {
+            for (const std::string& path : paths) unlink(path.c_str());
+        }
+        paths.clear();
+        zipf.reset();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        PERF_TEST_ASSERT(!fds.empty(), "No files open (setup failed?)", result);
+
+        std::vector<std::unique_ptr<ThreadStats>> stats(num_threads);
+        for (auto& s : stats) s = std::make_unique<ThreadStats>();
+
+        std::vector<std::thread> threads;
+        {
+            ScopedTimer timer(result.duration_ns);
+            RegionTimer region(result.regions["mixed"]);
+            uint64_t deadline = runtime_s > 0 ? now_ns() + static_cast<uint64_t>(runtime_s * 1e9) : 0;
+            for (int i = 0; i < num_threads; ++i) {
+                threads.emplace_back([&, i] { run_thread(i, deadline, *stats[i]); });
+            }
+            for (auto& t : threads) t.join();
+            if (mix != Mix::READ_ONLY) {
+                for (int fd : fds) fdatasync(fd); // Writes count once they are durable
+            }
+            for (const auto& s : stats) region.add_bytes(s->read_bytes + s->write_bytes);
+        }
+
+        uint64_t reads = 0, writes = 0, read_bytes = 0, write_bytes = 0;
+        for (const auto& s : stats) {
+            PERF_TEST_ASSERT(s->ok, s->error, result);
+            reads += s->reads;
+            writes += s->writes;
+            read_bytes += s->read_bytes;
+            write_bytes += s->write_bytes;
+            if (s->reads) result.histograms["read"].merge(s->read_latency);
+            if (s->writes) result.histograms["write"].merge(s->write_latency);
+        }
+
+        double elapsed_s = result.duration_ns / 1.0e9;
+        const double MIB = 1024.0 * 1024.0;
+        result.success = true;
+        result.metrics["reads"] = reads;
+        result.metrics["writes"] = writes;
+        result.metrics["read_iops"] = reads / elapsed_s;
+        result.metrics["write_iops"] = writes / elapsed_s;
+        result.metrics["iops"] = (reads + writes) / elapsed_s;
+        result.metrics["read_mib_per_sec"] = read_bytes / MIB / elapsed_s;
+        result.metrics["write_mib_per_sec"] = write_bytes / MIB / elapsed_s;
+        result.metrics["mib_per_sec"] = (read_bytes + write_bytes) / MIB / elapsed_s;
+        result.metrics["pattern"] = get_param(context, "pattern", "sequential");
+        result.metrics["read_pct"] = read_pct;
+        result.metrics["block_size"] = get_param(context, "block_size", "4k");
+        result.metrics["num_threads"] = num_threads;
+        return result;
+    }
+};
+
+REGISTER_TEST("mixed_workload", [](const TestContext& config) {
+    return std::make_unique<MixedWorkloadBench>(config);
+});
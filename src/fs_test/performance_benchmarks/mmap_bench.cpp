@@ -0,0 +1,254 @@
+#include "../test_common.hpp"
+#include "../page_cache.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+/**
+ * @brief Bandwidth and page faults of file I/O through mmap() instead of
+ * read()/write(), the way numpy.memmap or HDF5's core driver touch data.
+ *
+ * A pass maps the whole file, optionally madvise()s it, copies every chunk
+ * out of (read) or into (write) the mapping in the chosen order, msync()s
+ * a writable mapping and unmaps it. The whole pass, mmap() to munmap(), is
+ * timed: with MAP_POPULATE the faulting happens inside mmap() itself.
+ * Major and minor fault counts come from getrusage(RUSAGE_THREAD) around
+ * the pass, so they cover only this thread.
+ *
+ * Every combination of mode, pattern, populate and advice is one pass,
+ * tagged "<mode>_<pattern>_<populate>_<advice>" (e.g.
+ * "read_random_demand_willneed"). Per tag: gbps, seconds, major_faults,
+ * minor_faults, advice_applied (0 if madvise() refused the hint; the pass
+ * still runs), a per-chunk latency histogram and a region for the server's
+ * aggregate bandwidth.
+ *
+ * Read passes use file_path, so running cache_read with the same file and
+ * cache_modes gives the read() path to compare against. Write passes use a
+ * per-worker file of write_size_mb, sized with ftruncate() but not filled,
+ * as np.memmap(mode="w+") leaves it. The file is truncated to 0 and back
+ * before every write pass (untimed), so each pass faults into holes
+ * rather than overwriting what the previous pass allocated.
+ *
+ * Params:
+ * - num_workers:   server only, workers to run on (default 1).
+ * - root:          server only, where write files are created.
+ * - file_path:     read only, the file to map.
+ * - modes:         comma-separated read and/or write (default read).
+ * - patterns:      comma-separated sequential and/or random (default both).
+ *                  random touches the chunks in a shuffled order.
+ * - populate:      comma-separated demand and/or populate (MAP_POPULATE)
+ *                  (default both).
+ * - advice:        comma-separated none, sequential, willneed, hugepage
+ *                  (MADV_*) (default none).
+ * - cache_mode:    "cold" (default): the file is evicted from the page cache
+ *                  before each pass; "hot": it is loaded first.
+ * - chunk_kb:      bytes copied per access (default 64).
+ * - write_size_mb: write only, size of each worker's file (default 1024).
+ */
+class MmapBench: public BaseTest {
+private:
+    static constexpr double GIB = 1024.0 * 1024.0 * 1024.0;
+
+    struct Pass {
+        bool write;
+        bool random;
+        bool populate;
+        std::string advice;
+        std::string tag;
+    };
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::vector<Pass> passes;
+    bool hot = false;
+    size_t chunk_size = 0;
+    std::string read_path;
+    std::string write_path;
+    uint64_t write_size = 0;
+    AlignedBuffer chunk;
+    // Chunk order of the random pattern, per file; built once in setup.
+    std::vector<uint64_t> read_order;
+    std::vector<uint64_t> write_order;
+
+    static int advice_flag(const std::string& advice) {
+        if (advice == "sequential") return MADV_SEQUENTIAL;
+        if (advice == "willneed") return MADV_WILLNEED;
+        if (advice == "hugepage") return MADV_HUGEPAGE;
+        return -1;
+    }
+
+    std::vector<uint64_t> shuffled_chunks(uint64_t file_size, uint64_t seed) const {
+        std::vector<uint64_t> order((file_size + chunk_size - 1) / chunk_size);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(seed));
+        return order;
+    }
+
+    /** @return An error message, empty on success. */
+    std::string run_pass(const Pass& pass, TestResult& result) {
+        const std::string& path = pass.write ? write_path : read_path;
+        if (pass.write && (truncate(path.c_str(), 0) != 0 || truncate(path.c_str(), write_size) != 0)) {
+            return "truncate of " + path + " failed";
+        }
+        if (hot ? !page_cache::load(path) : !page_cache::evict(path)) return "Setting cache state of " + path + " failed";
+        int fd = open(path.c_str(), pass.write ? O_RDWR : O_RDONLY);
+        if (fd < 0) return "open of " + path + " failed";
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return "fstat of " + path + " failed or file is empty";
+        }
+        const uint64_t size = st.st_size;
+        const std::vector<uint64_t>& order = pass.write ? write_order : read_order;
+        const uint64_t chunks = (size + chunk_size - 1) / chunk_size;
+        if (pass.random && order.size() != chunks) {
+            close(fd);
+            return path + " changed size since setup";
+        }
+
+        LatencyHistogram& latency = result.histograms[pass.tag];
+        bool advice_applied = true;
+        std::string error;
+        struct rusage before, after;
+        getrusage(RUSAGE_THREAD, &before);
+        uint64_t start = now_ns();
+        {
+            RegionTimer region(result.regions[pass.tag]);
+            int prot = pass.write ? PROT_READ | PROT_WRITE : PROT_READ;
+            void* map = mmap(nullptr, size, prot, MAP_SHARED | (pass.populate ? MAP_POPULATE : 0), fd, 0);
+            if (map == MAP_FAILED) {
+                close(fd);
+                return "mmap of " + path + " failed";
+            }
+            char* base = static_cast<char*>(map);
+            int flag = advice_flag(pass.advice);
+            if (flag >= 0) advice_applied = madvise(map, size, flag) == 0;
+
+            for (uint64_t i = 0; i < chunks; ++i) {
+                uint64_t offset = (pass.random ? order[i] : i) * chunk_size;
+                size_t len = std::min<uint64_t>(chunk_size, size - offset);
+                uint64_t op_start = now_ns();
+                if (pass.write) {
+                    // Stamp each chunk with its offset so the data isn't one repeated page.
+                    memcpy(chunk.data(), &offset, sizeof(offset));
+                    memcpy(base + offset, chunk.data(), len);
+                } else {
+                    memcpy(chunk.data(), base + offset, len);
+                }
+                latency.record(now_ns() - op_start);
+                progress_add(len);
+                region.add_bytes(len);
+            }
+            if (pass.write && msync(map, size, MS_SYNC) != 0) error = "msync of " + path + " failed";
+            munmap(map, size);
+        }
+        uint64_t elapsed = now_ns() - start;
+        getrusage(RUSAGE_THREAD, &after);
+        close(fd);
+        if (!error.empty()) return error;
+
+        double seconds = elapsed / 1.0e9;
+        result.metrics[pass.tag + "_gbps"] = size / GIB / seconds;
+        result.metrics[pass.tag + "_s"] = seconds;
+        result.metrics[pass.tag + "_major_faults"] = after.ru_majflt - before.ru_majflt;
+        result.metrics[pass.tag + "_minor_faults"] = after.ru_minflt - before.ru_minflt;
+        result.metrics[pass.tag + "_advice_applied"] = advice_applied ? 1 : 0;
+        return "";
+    }
+
+public:
+    explicit MmapBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/mmap_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::vector<std::string> modes = split(get_param(config, "modes", "read"));
+        bool reads = std::find(modes.begin(), modes.end(), "read") != modes.end();
+        bool writes = std::find(modes.begin(), modes.end(), "write") != modes.end();
+        if (reads && !std::filesystem::exists(get_param(config, "file_path", ""))) return false;
+        if (writes) std::filesystem::create_directories(g_test_dir);
+
+        worker_contexts = make_worker_contexts(config, "default");
+        for (TestContext& context : worker_contexts) context.params["test_dir"] = g_test_dir.string();
+        return true;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        std::string cache_mode = get_param(context, "cache_mode", "cold");
+        if (cache_mode != "cold" && cache_mode != "hot") return false;
+        hot = cache_mode == "hot";
+        chunk_size = std::stoul(get_param(context, "chunk_kb", "64")) * 1024;
+        if (chunk_size == 0 || !chunk.allocate(chunk_size)) return false;
+
+        passes.clear();
+        for (const std::string& mode : split(get_param(context, "modes", "read"))) {
+            if (mode != "read" && mode != "write") return false;
+            for (const std::string& pattern : split(get_param(context, "patterns", "sequential,random"))) {
+                if (pattern != "sequential" && pattern != "random") return false;
+                for (const std::string& populate : split(get_param(context, "populate", "demand,populate"))) {
+                    if (populate != "demand" && populate != "populate") return false;
+                    for (const std::string& advice : split(get_param(context, "advice", "none"))) {
+                        if (advice != "none" && advice_flag(advice) < 0) return false;
+                        std::string tag = mode + "_" + pattern + "_" + populate + "_" + advice;
+                        passes.push_back({mode == "write", pattern == "random", populate == "populate", advice, tag});
+                    }
+                }
+            }
+        }
+        if (passes.empty()) return false;
+
+        read_order.clear();
+        write_order.clear();
+        for (const Pass& pass : passes) {
+            if (!pass.write && read_path.empty()) {
+                read_path = get_param(context, "file_path", "");
+                struct stat st;
+                if (stat(read_path.c_str(), &st) != 0 || st.st_size == 0) return false;
+                read_order = shuffled_chunks(st.st_size, context.worker_id);
+            }
+            if (pass.write && write_path.empty()) {
+                write_path = context.params.at("test_dir") + "/w" + std::to_string(context.worker_id) + ".bin";
+                write_size = std::stoull(get_param(context, "write_size_mb", "1024")) * 1024 * 1024;
+                int fd = open(write_path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+                if (fd < 0) return false;
+                bool sized = write_size > 0 && ftruncate(fd, write_size) == 0;
+                close(fd);
+                if (!sized) return false;
+                write_order = shuffled_chunks(write_size, context.worker_id);
+            }
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        if (!write_path.empty()) unlink(write_path.c_str());
+        read_path.clear();
+        write_path.clear();
+        read_order.clear();
+        write_order.clear();
+        chunk.clear();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        {
+            ScopedTimer timer(result.duration_ns);
+            for (const Pass& pass : passes) {
+                std::string error = run_pass(pass, result);
+                PERF_TEST_ASSERT(error.empty(), pass.tag + ": " + error, result);
+            }
+        }
+        result.success = true;
+        result.metrics["chunk_kb"] = chunk_size / 1024;
+        return result;
+    }
+};
+
+REGISTER_TEST("mmap_io", [](const TestContext& config) {
+    return std::make_unique<MmapBench>(config);
+});
@@ -1,15 +1,208 @@
 #include "../test_common.hpp"
+#include "../io_uring_engine.hpp"
 
+#include <memory>
+
+/**
+ * @brief Large sequential O_DIRECT write throughput.
+ *
+ * Each worker writes its own file; the server reports the cluster-wide
+ * bandwidth of each engine from the workers' "<engine>_write" regions.
+ *
+ * Params:
+ * - root:         server only, directory the per-worker files are created in.
+ * - num_workers:  server only, workers to run on (default 1).
+ * - file_path, file_size_gb, block_size_mb
+ * - engine:       comma-separated list of "sync" and/or "uring" (default "sync").
+ *                 Engines run back-to-back on the same file so they can be
+ *                 compared within one run; metrics are prefixed by engine name.
+ *                 The file is truncated (untimed) before each engine, so every
+ *                 engine pays for block allocation, not just the first.
+ * - iodepth:      uring only, max writes in flight (default 32).
+ * - num_buffers:  uring only, distinct registered buffers (default iodepth).
+ * - submit_batch: uring only, SQEs queued before each io_uring_enter (default 8).
+ */
 class SequentialWriteThroughputBench: public BaseTest {
 private:
-    std::vector<char> write_buffer;
-    int write_fd;
+    struct EngineStats {
+        uint64_t duration_ns = 0;
+        uint64_t submit_calls = 0;
+        uint64_t submit_ns_total = 0;
+        uint64_t submit_ns_max = 0;
+        uint64_t completions = 0;
+        uint64_t complete_ns_total = 0;
+        uint64_t complete_ns_max = 0;
+        LatencyHistogram write_latency;  // Per write (sync) / per completion (uring)
+        LatencyHistogram submit_latency; // uring only, per io_uring_enter()
+    };
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::vector<AlignedBuffer> write_buffers;
+    std::vector<std::string> engines;
+    int write_fd = -1;
+    unsigned iodepth = 32;
+    unsigned submit_batch = 8;
+
+    /**
+     * @brief The original loop: one blocking write at a time (queue depth 1).
+     */
+    bool run_sync(long long bytes_to_write, EngineStats& stats) {
+        const AlignedBuffer& buffer = write_buffers[0];
+        size_t block_size = buffer.size();
+        long long bytes_written = 0;
+        uint64_t start = now_ns();
+        while (bytes_written < bytes_to_write) {
+            uint64_t op_start = now_ns();
+            ssize_t written = pwrite(write_fd, buffer.data(), block_size, bytes_written);
+            if (written != (ssize_t)block_size) return false;
+            stats.write_latency.record(now_ns() - op_start);
+            progress_add(written);
+            bytes_written += written;
+        }
+        if (fdatasync(write_fd) != 0) return false; // Ensure data is on disk
+        stats.duration_ns = now_ns() - start;
+        return true;
+    }
+
+    /**
+     * @brief Keeps up to `iodepth` writes in flight through io_uring.
+     *
+     * Submit latency is the time spent in io_uring_enter() per batch;
+     * completion latency is per write, from SQE preparation to CQE reap.
+     */
+    bool run_uring(long long bytes_to_write, EngineStats& stats) {
+        IoUring ring;
+        if (!ring.init(iodepth)) return false;
+        unsigned depth = std::min(iodepth, ring.sq_entries());
+
+        std::vector<iovec> iovecs(write_buffers.size());
+        for (size_t i = 0; i < write_buffers.size(); ++i) {
+            iovecs[i] = {write_buffers[i].data(), write_buffers[i].size()};
+        }
+        // Fixed buffers skip per-I/O page pinning; fall back to plain writes
+        // if the memlock limit doesn't allow registering them.
+        bool fixed = ring.register_buffers(iovecs.data(), iovecs.size());
+
+        size_t block_size = write_buffers[0].size();
+        std::vector<uint64_t> issue_ns(depth);
+        std::vector<unsigned> free_slots(depth);
+        for (unsigned i = 0; i < depth; ++i) free_slots[i] = depth - 1 - i;
+
+        long long next_offset = 0;
+        long long bytes_completed = 0;
+        unsigned inflight = 0;
+        unsigned pending = 0;
+        uint64_t start = now_ns();
+
+        while (bytes_completed < bytes_to_write || inflight > 0) {
+            // 1. Queue SQEs until a batch is ready, the depth is reached or the file is covered.
+            bool sq_full = false;
+            while (pending < submit_batch && inflight + pending < depth && next_offset < bytes_to_write) {
+                io_uring_sqe* sqe = ring.get_sqe();
+                if (!sqe) {
+                    sq_full = true;
+                    break;
+                }
+                unsigned slot = free_slots.back();
+                free_slots.pop_back();
+                unsigned buf_index = slot % write_buffers.size();
+                const char* buf = write_buffers[buf_index].data();
+                if (fixed) {
+                    IoUring::prep_write_fixed(sqe, write_fd, buf, block_size, next_offset, buf_index, slot);
+                } else {
+                    IoUring::prep_write(sqe, write_fd, buf, block_size, next_offset, slot);
+                }
+                issue_ns[slot] = now_ns();
+                next_offset += block_size;
+                ++pending;
+            }
+
+            // 2. Submit once a batch is ready; a short batch only at the depth / EOF tail.
+            bool must_submit = sq_full || inflight + pending >= depth || next_offset >= bytes_to_write;
+            if (pending > 0 && (pending >= submit_batch || must_submit)) {
+                uint64_t t0 = now_ns();
+                if (ring.submit() < 0) return false;
+                uint64_t submit_ns = now_ns() - t0;
+                stats.submit_calls++;
+                stats.submit_ns_total += submit_ns;
+                stats.submit_ns_max = std::max(stats.submit_ns_max, submit_ns);
+                stats.submit_latency.record(submit_ns);
+                inflight += pending;
+                pending = 0;
+            }
+
+            // 3. Reap. Block only if we cannot queue anything else.
+            if (inflight == 0) continue;
+            bool must_wait = inflight >= depth || next_offset >= bytes_to_write;
+            io_uring_cqe* cqe = must_wait ? ring.wait_cqe() : ring.peek_cqe();
+            if (must_wait && !cqe) return false;
+            while (cqe) {
+                unsigned slot = static_cast<unsigned>(cqe->user_data);
+                int res = cqe->res;
+                ring.cqe_seen();
+                if (res != (int)block_size) {
+                    errno = (res < 0) ? -res : EIO;
+                    return false;
+                }
+                uint64_t complete_ns = now_ns() - issue_ns[slot];
+                stats.completions++;
+                stats.complete_ns_total += complete_ns;
+                stats.complete_ns_max = std::max(stats.complete_ns_max, complete_ns);
+                stats.write_latency.record(complete_ns);
+                progress_add(res);
+                free_slots.push_back(slot);
+                bytes_completed += res;
+                --inflight;
+                cqe = ring.peek_cqe();
+            }
+        }
+        if (fdatasync(write_fd) != 0) return false; // Ensure data is on disk
+        stats.duration_ns = now_ns() - start;
+        return true;
+    }
+
 public:
+    explicit SequentialWriteThroughputBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/sequential_write_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        worker_contexts = make_worker_contexts(config, "writer");
+        for (TestContext& context : worker_contexts) {
+            context.params["file_path"] = (g_test_dir / ("worker_" + std::to_string(context.worker_id) + ".bin")).string();
+        }
+        return true;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
     bool worker_setup(const TestContext& context) override {
         size_t block_size_mb = std::stoll(context.params.at("block_size_mb"));
-        write_buffer.resize(block_size_mb * 1024 * 1024);
-        // Fill buffer once
-        std::fill(write_buffer.begin(), write_buffer.end(), 'A');
+        iodepth = std::stoul(get_param(context, "iodepth", "32"));
+        submit_batch = std::stoul(get_param(context, "submit_batch", "8"));
+        size_t num_buffers = std::stoul(get_param(context, "num_buffers", std::to_string(iodepth)));
+        if (iodepth == 0 || submit_batch == 0 || num_buffers == 0) return false;
+
+        engines.clear();
+        for (const std::string& engine : split(get_param(context, "engine", "sync"))) {
+            if (engine != "sync" && engine != "uring") return false;
+            engines.push_back(engine);
+        }
+        if (engines.empty()) return false;
+        bool use_uring = std::find(engines.begin(), engines.end(), "uring") != engines.end();
+
+        // The sync engine only ever uses the first buffer.
+        write_buffers.clear();
+        write_buffers.resize(use_uring ? num_buffers : 1);
+        for (auto& buffer : write_buffers) {
+            if (!buffer.allocate(block_size_mb * 1024 * 1024)) return false;
+            // Fill buffer once
+            std::fill(buffer.begin(), buffer.end(), 'A');
+        }
 
         write_fd = open(context.params.at("file_path").c_str(), O_CREAT | O_WRONLY | O_DIRECT, 0644);
         return (write_fd >= 0);
@@ -17,7 +210,7 @@ public:
     void worker_cleanup(const TestContext& context) {
         if (write_fd >= 0) close(write_fd);
         write_fd = -1;
-        write_buffer.clear();
+        write_buffers.clear();
     }
     TestResult worker_execute(const TestContext& context) {
         TestResult result;
@@ -25,22 +218,46 @@ public:
 
         long long size_gb = std::stoll(context.params.at("file_size_gb"));
         long long bytes_to_write = size_gb * 1024 * 1024 * 1024;
-        long long bytes_written = 0;
-        size_t block_size = write_buffer.size();
 
         ScopedTimer timer(result.duration_ns);
-        while (bytes_written < bytes_to_write) {
-            ssize_t written = write(write_fd, write_buffer.data(), block_size);
-            PERF_TEST_ASSERT(written == (ssize_t)block_size, "write() failed", result);
-            bytes_written += written;
+        for (const std::string& engine : engines) {
+            PERF_TEST_ASSERT(ftruncate(write_fd, 0) == 0, engine + ": ftruncate() failed", result);
+            auto stats_ptr = std::make_unique<EngineStats>();
+            EngineStats& stats = *stats_ptr;
+            bool ok;
+            {
+                RegionTimer region(result.regions[engine + "_write"]);
+                ok = (engine == "uring") ? run_uring(bytes_to_write, stats) : run_sync(bytes_to_write, stats);
+                region.add_bytes(bytes_to_write);
+            }
+            PERF_TEST_ASSERT(ok, engine == "uring" ? "io_uring write failed" : "write() failed", result);
+
+            double duration_s = stats.duration_ns / 1.0e9;
+            double gbps = static_cast<double>(size_gb) / duration_s;
+            result.metrics[engine + "_throughput_gbps"] = gbps;
+            result.metrics[engine + "_duration_s"] = duration_s;
+            result.histograms[engine + "_write"].merge(stats.write_latency);
+            if (engine == "uring") {
+                result.metrics["uring_iodepth"] = iodepth;
+                result.metrics["uring_submit_calls"] = stats.submit_calls;
+                result.metrics["uring_submit_lat_avg_us"] = stats.submit_ns_total / 1.0e3 / std::max<uint64_t>(stats.submit_calls, 1);
+                result.metrics["uring_submit_lat_max_us"] = stats.submit_ns_max / 1.0e3;
+                result.metrics["uring_complete_lat_avg_us"] = stats.complete_ns_total / 1.0e3 / std::max<uint64_t>(stats.completions, 1);
+                result.metrics["uring_complete_lat_max_us"] = stats.complete_ns_max / 1.0e3;
+                result.histograms["uring_submit"].merge(stats.submit_latency);
+            }
+            // Keep the original key for whichever engine was listed first.
+            if (result.metrics.count("throughput_gbps") == 0) {
+                result.metrics["throughput_gbps"] = gbps;
+            }
         }
-        fdatasync(write_fd); // Ensure data is on disk
-        
+
         // Timer stops here
         result.success = true;
-        double duration_s = result.duration_ns / 1.0e9;
-        double gbps = static_cast<double>(size_gb) / duration_s;
-        result.metrics["throughput_gbps"] = std::to_string(gbps);
         return result;
     }
 };
+
+REGISTER_TEST("sequential_write", [](const TestContext& config) {
+    return std::make_unique<SequentialWriteThroughputBench>(config);
+});
@@ -0,0 +1,240 @@
+#include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
+#include "../path_arena.hpp"
+#include "../round_merge.hpp"
+
+#include <memory>
+
+/**
+ * @brief Many clients creating in ONE directory at the same time.
+ *
+ * metadata_ops gives every thread its own directory; this is the case it
+ * leaves out: every thread of every worker works on unique names inside a
+ * single shared directory, so the directory itself (its lock, its entries
+ * block, the server that owns it) is what's contended.
+ *
+ * Phases run in order, each as its own synchronized round across the
+ * workers, so no worker is still creating while another is already
+ * stat()ing:
+ * - create: open(O_CREAT | O_EXCL) + close
+ * - stat:   stat()
+ * - unlink: unlink()
+ * To see how the directory scales, the whole sequence is repeated for each
+ * entry of worker_counts, using the first N workers. Names include N, so
+ * rounds never reuse each other's entries. When the server repeats a
+ * phase's execute (iteration policy), create and unlink first restore the
+ * names to how the first execute found them, untimed.
+ *
+ * Per worker, metrics are prefixed "n<N>_<phase>_": ops, ops_per_sec and the
+ * p50 / p99 / p999 / max latency in microseconds. "<prefix>cluster_ops_per_sec"
+ * is all workers' ops over the span from the first start to the last finish,
+ * the same on every worker of the round.
+ *
+ * Params:
+ * - root:             server only, directory the shared directory is created in.
+ * - num_workers:      server only, workers available (default 1).
+ * - worker_counts:    server only, comma-separated worker counts to sweep
+ *                     (default num_workers). None may exceed num_workers.
+ * - phases:           comma-separated subset of create, stat, unlink (default
+ *                     all). stat and unlink expect create to run too.
+ * - num_threads:      threads per worker (default 4).
+ * - files_per_thread: names each thread works on per round (default 1000).
+ */
+class SharedDirStormBench: public BaseTest {
+private:
+    struct ThreadStats {
+        LatencyHistogram latency;
+        bool ok = true;
+        std::string error;
+    };
+
+    enum class Op { CREATE, STAT, UNLINK };
+
+    static constexpr const char* ALL_PHASES[] = {"create", "stat", "unlink"};
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::string phase;
+    std::string tag; // n<worker_count>_<phase>
+    Op op = Op::CREATE;
+    int num_threads = 1;
+    std::vector<PathArena> thread_paths;
+
+    static void fail(ThreadStats& stats, const std::string& msg) {
+        stats.ok = false;
+        stats.error = msg + " (errno: " + get_error_str() + ")";
+    }
+
+    void run_thread(int thread_id, ThreadStats& stats) {
+        const PathArena& paths = thread_paths[thread_id];
+        for (size_t i = 0; i < paths.size(); ++i) {
+            uint64_t op_start = now_ns();
+            switch (op) {
+                case Op::CREATE: {
+                    int fd = open(paths[i], O_CREAT | O_EXCL | O_WRONLY, 0644);
+                    if (fd < 0) return fail(stats, std::string("create of ") + paths[i] + " failed");
+                    close(fd);
+                    break;
+                }
+                case Op::STAT: {
+                    struct stat st;
+                    if (stat(paths[i], &st) != 0) return fail(stats, std::string("stat of ") + paths[i] + " failed");
+                    break;
+                }
+                case Op::UNLINK:
+                    if (unlink(paths[i]) != 0) return fail(stats, std::string("unlink of ") + paths[i] + " failed");
+                    break;
+            }
+            stats.latency.record(now_ns() - op_start);
+            progress_add(0);
+        }
+    }
+
+    /**
+     * @brief Untimed, before a repeated execute (context.iteration > 0):
+     * puts this worker's names back the way the phase found them the first
+     * time, so create doesn't hit EEXIST and unlink has files to remove.
+     */
+    bool restore_names() const {
+        for (const PathArena& paths : thread_paths) {
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (op == Op::CREATE && unlink(paths[i]) != 0 && errno != ENOENT) return false;
+                if (op == Op::UNLINK) {
+                    int fd = open(paths[i], O_CREAT | O_WRONLY, 0644);
+                    if (fd < 0) return false;
+                    close(fd);
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    explicit SharedDirStormBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/shared_dir_storm_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        int num_workers = std::stoi(get_param(config, "num_workers", "1"));
+        for (const std::string& count : split(get_param(config, "worker_counts", std::to_string(num_workers)))) {
+            int n = std::stoi(count);
+            if (n <= 0 || n > num_workers) return false;
+        }
+        worker_contexts = make_worker_contexts(config, "default");
+        for (TestContext& context : worker_contexts) context.params["test_dir"] = g_test_dir.string();
+        return true;
+    }
+    std::vector<TestResult> global_execute(
+        GrpcClientManager& grpc_clients,
+        const std::vector<TestContext>& worker_contexts
+    ) {
+        std::vector<std::string> phases;
+        std::vector<std::string> requested = split(get_param(config, "phases", "create,stat,unlink"));
+        for (const char* p : ALL_PHASES) {
+            if (std::find(requested.begin(), requested.end(), p) != requested.end()) phases.push_back(p);
+        }
+
+        std::vector<TestResult> merged(worker_contexts.size());
+        std::string counts = get_param(config, "worker_counts", std::to_string(worker_contexts.size()));
+        for (const std::string& count : split(counts)) {
+            size_t n = std::stoul(count);
+            for (const std::string& phase : phases) {
+                std::vector<TestContext> round(worker_contexts.begin(), worker_contexts.begin() + n);
+                for (TestContext& context : round) {
+                    context.total_workers = static_cast<int>(n);
+                    context.params["worker_count"] = count;
+                    context.params["phase"] = phase;
+                }
+                std::string tag = "n" + count + "_" + phase;
+                std::vector<TestResult> results = grpc_clients.run_all(round);
+
+                // Regions are already on the server clock, so spans are comparable.
+                uint64_t first_start = UINT64_MAX, last_end = 0, ops = 0;
+                for (const TestResult& r : results) {
+                    auto region = r.regions.find(tag);
+                    auto op_count = r.metrics.find(tag + "_ops");
+                    if (region == r.regions.end() || op_count == r.metrics.end()) continue;
+                    first_start = std::min(first_start, region->second.start_ns);
+                    last_end = std::max(last_end, region->second.end_ns);
+                    ops += op_count->second.as_int();
+                }
+                merge_round(merged, results, tag);
+                if (last_end > first_start) {
+                    double cluster_rate = ops / ((last_end - first_start) / 1.0e9);
+                    for (size_t w = 0; w < n; ++w) merged[w].metrics[tag + "_cluster_ops_per_sec"] = cluster_rate;
+                }
+                bool all_ok = std::all_of(merged.begin(), merged.end(), [](const TestResult& r) { return r.success; });
+                if (!all_ok) return merged;
+            }
+        }
+        return merged;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        phase = get_param(context, "phase", "create");
+        if (phase == "create") op = Op::CREATE;
+        else if (phase == "stat") op = Op::STAT;
+        else if (phase == "unlink") op = Op::UNLINK;
+        else return false;
+        std::string worker_count = get_param(context, "worker_count", std::to_string(context.total_workers));
+        tag = "n" + worker_count + "_" + phase;
+        num_threads = std::stoi(get_param(context, "num_threads", "4"));
+        size_t files_per_thread = std::stoul(get_param(context, "files_per_thread", "1000"));
+        if (num_threads <= 0) return false;
+
+        // n<N>.w<worker>.t<thread>.<i>: unique across threads, workers and rounds.
+        std::string test_dir = context.params.at("test_dir");
+        thread_paths.clear();
+        thread_paths.resize(num_threads);
+        for (int t = 0; t < num_threads; ++t) {
+            std::string prefix = test_dir + "/n" + worker_count + ".w" + std::to_string(context.worker_id) +
+                                 ".t" + std::to_string(t) + ".";
+            thread_paths[t].reserve(files_per_thread, files_per_thread * (prefix.size() + 12));
+            for (size_t i = 0; i < files_per_thread; ++i) thread_paths[t].add(prefix, std::to_string(i));
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        // Entries stay until global_cleanup(): the next round needs them.
+        thread_paths.clear();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        if (context.iteration > 0) {
+            PERF_TEST_ASSERT(restore_names(), "Restoring the names of the last execute failed", result);
+        }
+        std::vector<std::unique_ptr<ThreadStats>> stats(num_threads);
+        for (auto& s : stats) s = std::make_unique<ThreadStats>();
+        {
+            ScopedTimer timer(result.duration_ns);
+            RegionTimer region(result.regions[tag]);
+            std::vector<std::thread> threads;
+            for (int i = 0; i < num_threads; ++i) threads.emplace_back([&, i] { run_thread(i, *stats[i]); });
+            for (auto& t : threads) t.join();
+        }
+
+        LatencyHistogram& latency = result.histograms[tag];
+        for (const auto& s : stats) {
+            PERF_TEST_ASSERT(s->ok, s->error, result);
+            latency.merge(s->latency);
+        }
+        double duration_s = result.duration_ns / 1.0e9;
+        result.success = true;
+        result.metrics[tag + "_ops"] = latency.count();
+        result.metrics[tag + "_ops_per_sec"] = latency.count() / duration_s;
+        result.metrics[tag + "_p50_us"] = latency.percentile(50.0) / 1000.0;
+        result.metrics[tag + "_p99_us"] = latency.percentile(99.0) / 1000.0;
+        result.metrics[tag + "_p999_us"] = latency.percentile(99.9) / 1000.0;
+        result.metrics[tag + "_max_us"] = latency.max() / 1000.0;
+        return result;
+    }
+};
+
+REGISTER_TEST("shared_dir_storm", [](const TestContext& config) {
+    return std::make_unique<SharedDirStormBench>(config);
+});
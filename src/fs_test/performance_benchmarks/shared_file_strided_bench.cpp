@@ -0,0 +1,257 @@
+#include "../test_common.hpp"
+#include "../grpc_client_manager.hpp"
+#include "../round_merge.hpp"
+
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief N-to-1 checkpoint pattern (IOR -F off): every rank writes disjoint
+ * parts of one shared file at the same time.
+ *
+ * Ranks are worker threads; worker w runs ranks [w * ranks_per_worker,
+ * (w + 1) * ranks_per_worker). Each rank writes bytes_per_rank in
+ * block_size transfers, laid out either
+ * - contiguous:  rank r owns one segment, [r * bytes_per_rank, (r + 1) * bytes_per_rank)
+ *   (IOR segmented), or
+ * - interleaved: transfer i of rank r lands at (i * total_ranks + r) * block_size
+ *   (IOR strided), so neighbouring ranks share every stripe and lock range.
+ *
+ * The server runs every (layout, block size) combination as its own
+ * synchronized round, so all ranks always write the same layout together.
+ * With read_back=1, each combination is followed by a second round in which
+ * every rank reads and checks what the matching rank of the next worker
+ * wrote, so the data must come from another node.
+ *
+ * Per worker, metrics are prefixed "<layout>_<block_size>_<write|read>_".
+ * "<prefix>slowdown" is the worker's time over the fastest worker's, which
+ * together with the cluster region summary shows the contention skew.
+ *
+ * Params:
+ * - root:             server only, directory the shared file is created in.
+ * - num_workers:      server only, workers to run on (default 1).
+ * - layouts:          server only, comma-separated "contiguous" and/or
+ *                     "interleaved" (default both).
+ * - block_sizes:      server only, comma-separated transfer sizes with k/m
+ *                     suffixes (default "4k,64k,1m,16m").
+ * - read_back:        server only, 1 to read back a neighbour's data (default 0).
+ * - ranks_per_worker: threads per worker (default 1).
+ * - bytes_per_rank_mb: data each rank writes per round (default 256).
+ * - direct:           1 to use O_DIRECT (default 0).
+ */
+class SharedFileStridedBench: public BaseTest {
+private:
+    struct RankStats {
+        uint64_t ops = 0;
+        uint64_t bytes = 0;
+        LatencyHistogram latency;
+        bool ok = true;
+        std::string error;
+    };
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    // Per round, set by the server
+    std::string phase;  // "write" or "read"
+    std::string layout;
+    std::string block_label;
+    uint64_t block_size = 0;
+    std::string tag;    // <layout>_<block_label>_<phase>
+
+    int ranks_per_worker = 1;
+    int rank_base = 0;
+    int total_ranks = 1;
+    uint64_t blocks_per_rank = 0;
+    int fd = -1;
+    std::vector<AlignedBuffer> buffers;
+
+    uint64_t offset_of(int rank, uint64_t block) const {
+        return layout == "contiguous"
+            ? static_cast<uint64_t>(rank) * blocks_per_rank * block_size + block * block_size
+            : (block * total_ranks + rank) * block_size;
+    }
+
+    /**
+     * @brief Writes, or reads back and checks, all of one rank's transfers.
+     * Every transfer starts with its own offset, so a read can tell whether
+     * it got the right block.
+     */
+    void run_rank(int local_rank, RankStats& stats) {
+        char* buf = buffers[local_rank].data();
+        const int rank = rank_base + local_rank;
+        // Reads target the same local rank on the next worker.
+        const int target = phase == "write" ? rank : (rank + ranks_per_worker) % total_ranks;
+        for (uint64_t block = 0; block < blocks_per_rank; ++block) {
+            uint64_t offset = offset_of(target, block);
+            uint64_t op_start = now_ns();
+            ssize_t n;
+            if (phase == "write") {
+                std::memcpy(buf, &offset, sizeof(offset));
+                n = pwrite(fd, buf, block_size, offset);
+            } else {
+                n = pread(fd, buf, block_size, offset);
+            }
+            if (n != static_cast<ssize_t>(block_size)) {
+                stats.ok = false;
+                stats.error = phase + " of " + std::to_string(block_size) + " bytes at " + std::to_string(offset) +
+                              " failed (errno: " + get_error_str() + ")";
+                return;
+            }
+            stats.latency.record(now_ns() - op_start);
+            if (phase == "read") {
+                uint64_t stamp;
+                std::memcpy(&stamp, buf, sizeof(stamp));
+                if (stamp != offset) {
+                    stats.ok = false;
+                    stats.error = "read back wrong data at offset " + std::to_string(offset);
+                    return;
+                }
+            }
+            progress_add(n);
+            stats.ops++;
+            stats.bytes += n;
+        }
+    }
+
+    /** @brief merge_round(), plus each worker's slowdown against the round's fastest. */
+    static void absorb(std::vector<TestResult>& merged, const std::vector<TestResult>& round, const std::string& tag) {
+        uint64_t fastest = UINT64_MAX;
+        for (const TestResult& r : round) {
+            auto it = r.regions.find(tag);
+            if (it != r.regions.end()) fastest = std::min(fastest, it->second.end_ns - it->second.start_ns);
+        }
+        merge_round(merged, round, tag);
+        for (size_t w = 0; w < round.size(); ++w) {
+            const TestResult& r = round[w];
+            TestResult& out = merged[w];
+            auto it = r.regions.find(tag);
+            if (it != r.regions.end() && fastest > 0 && fastest != UINT64_MAX) {
+                out.metrics[tag + "_slowdown"] =
+                    static_cast<double>(it->second.end_ns - it->second.start_ns) / fastest;
+            }
+        }
+    }
+
+public:
+    explicit SharedFileStridedBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/shared_file_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        std::string file_path = (g_test_dir / "shared.bin").string();
+        int created = open(file_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+        if (created < 0) return false;
+        close(created);
+
+        int num_workers = std::stoi(get_param(config, "num_workers", "1"));
+        int ranks = std::stoi(get_param(config, "ranks_per_worker", "1"));
+        if (num_workers <= 0 || ranks <= 0) return false;
+        worker_contexts = make_worker_contexts(config, "writer");
+        for (TestContext& context : worker_contexts) {
+            context.params["file_path"] = file_path;
+            context.params["rank_base"] = std::to_string(context.worker_id * ranks);
+            context.params["total_ranks"] = std::to_string(num_workers * ranks);
+        }
+        return true;
+    }
+    std::vector<TestResult> global_execute(
+        GrpcClientManager& grpc_clients,
+        const std::vector<TestContext>& worker_contexts
+    ) {
+        bool read_back = get_param(config, "read_back", "0") == "1";
+        std::vector<TestResult> merged(worker_contexts.size());
+        for (const std::string& layout : split(get_param(config, "layouts", "contiguous,interleaved"))) {
+            for (const std::string& block : split(get_param(config, "block_sizes", "4k,64k,1m,16m"))) {
+                for (const char* phase : {"write", "read"}) {
+                    if (std::string(phase) == "read" && !read_back) continue;
+                    std::vector<TestContext> round = worker_contexts;
+                    for (TestContext& context : round) {
+                        context.role = phase == std::string("write") ? "writer" : "reader";
+                        context.params["layout"] = layout;
+                        context.params["block_size"] = block;
+                        context.params["phase"] = phase;
+                    }
+                    absorb(merged, grpc_clients.run_all(round), layout + "_" + block + "_" + phase);
+                    bool all_ok = std::all_of(merged.begin(), merged.end(), [](const TestResult& r) { return r.success; });
+                    if (!all_ok) return merged;
+                }
+            }
+        }
+        return merged;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        phase = get_param(context, "phase", "write");
+        layout = get_param(context, "layout", "contiguous");
+        block_label = get_param(context, "block_size", "1m");
+        block_size = parse_size(block_label);
+        tag = layout + "_" + block_label + "_" + phase;
+        ranks_per_worker = std::stoi(get_param(context, "ranks_per_worker", "1"));
+        rank_base = std::stoi(get_param(context, "rank_base", "0"));
+        total_ranks = std::stoi(get_param(context, "total_ranks", std::to_string(ranks_per_worker)));
+        uint64_t bytes_per_rank = std::stoull(get_param(context, "bytes_per_rank_mb", "256")) << 20;
+        if (phase != "write" && phase != "read") return false;
+        if (layout != "contiguous" && layout != "interleaved") return false;
+        if (block_size < sizeof(uint64_t) || ranks_per_worker <= 0 || total_ranks < ranks_per_worker) return false;
+        blocks_per_rank = std::max<uint64_t>(1, bytes_per_rank / block_size);
+
+        buffers.clear();
+        buffers.resize(ranks_per_worker);
+        for (auto& buffer : buffers) {
+            if (!buffer.allocate(block_size)) return false;
+            std::fill(buffer.begin(), buffer.end(), static_cast<char>('A' + context.worker_id % 26));
+        }
+        int flags = (phase == "write" ? O_WRONLY : O_RDONLY) |
+                    (get_param(context, "direct", "0") == "1" ? O_DIRECT : 0);
+        fd = open(context.params.at("file_path").c_str(), flags);
+        return fd >= 0;
+    }
+    void worker_cleanup(const TestContext& context) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+        buffers.clear();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        PERF_TEST_ASSERT(fd >= 0, "File not open (setup failed?)", result);
+
+        std::vector<std::unique_ptr<RankStats>> stats(ranks_per_worker);
+        for (auto& s : stats) s = std::make_unique<RankStats>();
+        bool synced = true;
+        {
+            ScopedTimer timer(result.duration_ns);
+            RegionTimer region(result.regions[tag]);
+            std::vector<std::thread> threads;
+            for (int i = 0; i < ranks_per_worker; ++i) threads.emplace_back([&, i] { run_rank(i, *stats[i]); });
+            for (auto& t : threads) t.join();
+            // A checkpoint only counts once it is durable.
+            if (phase == "write") synced = fdatasync(fd) == 0;
+            for (const auto& s : stats) region.add_bytes(s->bytes);
+        }
+        PERF_TEST_ASSERT(synced, "fdatasync() failed", result);
+
+        uint64_t ops = 0, bytes = 0;
+        for (const auto& s : stats) {
+            PERF_TEST_ASSERT(s->ok, s->error, result);
+            ops += s->ops;
+            bytes += s->bytes;
+            result.histograms[tag].merge(s->latency);
+        }
+        double elapsed_s = result.duration_ns / 1.0e9;
+        result.success = true;
+        result.metrics[tag + "_s"] = elapsed_s;
+        result.metrics[tag + "_ops"] = ops;
+        result.metrics[tag + "_gbps"] = bytes / (1024.0 * 1024.0 * 1024.0) / elapsed_s;
+        result.metrics[tag + "_iops"] = ops / elapsed_s;
+        return result;
+    }
+};
+
+REGISTER_TEST("shared_file_strided", [](const TestContext& config) {
+    return std::make_unique<SharedFileStridedBench>(config);
+});
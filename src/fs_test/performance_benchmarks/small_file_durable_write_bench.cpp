@@ -0,0 +1,300 @@
+#include "../test_common.hpp"
+#include "../path_arena.hpp"
+
+#include <deque>
+#include <memory>
+
+/**
+ * @brief Creating many small files and making them durable, under several
+ * sync strategies.
+ *
+ * metadata_ops creates empty files and sequential_write_throughput writes
+ * one big one; pipelines that emit hundreds of thousands of small outputs
+ * pay for create + write + sync, and how they sync matters most.
+ *
+ * Every thread creates files_per_thread files of file_size bytes (open
+ * O_CREAT | O_EXCL, one write(), close) in its own directory, under each
+ * strategy:
+ * - fdatasync:       fdatasync() every file, then fsync() its directory so
+ *                    the new name is durable too, before closing it.
+ * - syncfs:          close without syncing; syncfs() after every
+ *                    syncfs_batch files, and once more at the end.
+ * - sync_file_range: start writeback right after the write
+ *                    (SYNC_FILE_RANGE_WRITE), keep up to pipeline_depth files
+ *                    open, and fdatasync() the oldest once the pipeline is
+ *                    full, by which time its data is usually on its way.
+ *                    The directory is fsync()ed before a file is retired,
+ *                    once for every file created up to then.
+ *                    (sync_file_range() alone flushes neither metadata nor
+ *                    the device cache, so it is not durability on its own.)
+ * - none:            close without syncing; a single syncfs() after all
+ *                    threads are done makes everything durable.
+ *
+ * Each (strategy, size) is a pass tagged "<strategy>_<size>", e.g.
+ * "syncfs_4k". A pass ends when every file is durable. Per tag:
+ * files_per_sec and mib_per_sec (durable files over the pass), s, and
+ * time-to-durable per file (from open() until the sync covering it
+ * returned) as durable_p50_ms / durable_p99_ms / durable_max_ms and a
+ * histogram. The files are removed after each pass, untimed.
+ *
+ * Params:
+ * - root:             server only, directory test_dir is created in.
+ * - num_workers:      server only, workers to run on (default 1).
+ * - strategies:       comma-separated subset of fdatasync, syncfs,
+ *                     sync_file_range, none (default all).
+ * - file_sizes:       comma-separated sizes, suffix k/m allowed (default 4k).
+ * - num_threads:      writer threads per worker (default 4).
+ * - files_per_thread: files each thread writes per pass (default 1000).
+ * - syncfs_batch:     syncfs only, files between syncfs() calls (default 100).
+ * - pipeline_depth:   sync_file_range only, files in flight per thread (default 16).
+ */
+class SmallFileDurableWriteBench: public BaseTest {
+private:
+    enum class Strategy { FDATASYNC, SYNCFS, SYNC_FILE_RANGE, NONE };
+
+    struct Pass {
+        Strategy strategy;
+        uint64_t file_size;
+        std::string tag;
+        std::vector<PathArena> thread_paths;
+    };
+
+    /** @brief A sync_file_range file whose fdatasync() is still to come. */
+    struct InFlight {
+        int fd;
+        uint64_t opened;
+        size_t index; // Creation order within the pass
+    };
+
+    struct ThreadStats {
+        LatencyHistogram durable; // open() to durable, per file
+        std::vector<uint64_t> pending; // open() times of files not yet durable
+        bool ok = true;
+        std::string error;
+    };
+
+    static constexpr double MIB = 1024.0 * 1024.0;
+
+    TestContext config;
+    std::filesystem::path g_test_dir;
+
+    std::string worker_dir;
+    int num_threads = 1;
+    size_t syncfs_batch = 100;
+    size_t pipeline_depth = 16;
+    std::vector<Pass> passes;
+    AlignedBuffer data;
+
+    static void fail(ThreadStats& stats, const std::string& msg) {
+        stats.ok = false;
+        stats.error = msg + " (errno: " + get_error_str() + ")";
+    }
+
+    /** @brief Every pending file just became durable. */
+    static void settle(ThreadStats& stats) {
+        uint64_t now = now_ns();
+        for (uint64_t opened : stats.pending) stats.durable.record(now - opened);
+        stats.pending.clear();
+    }
+
+    /** @brief syncfs() on the filesystem holding the worker's files. */
+    bool sync_filesystem() const {
+        int fd = open(worker_dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) return false;
+        bool ok = syncfs(fd) == 0;
+        close(fd);
+        return ok;
+    }
+
+    void run_thread(const Pass& pass, int thread_id, ThreadStats& stats) {
+        std::string dir = worker_dir + "/t" + std::to_string(thread_id);
+        int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd < 0) return fail(stats, "open of " + dir + " failed");
+        std::deque<InFlight> in_flight; // sync_file_range only, oldest first
+        write_files(pass, thread_id, dir_fd, stats, in_flight);
+        for (const InFlight& file : in_flight) close(file.fd); // Only left over after a failure
+        close(dir_fd);
+    }
+
+    /**
+     * @param dir_fd The thread's directory: fsync()ing it makes the names
+     * created in it durable, which fdatasync() of the files does not.
+     */
+    void write_files(const Pass& pass, int thread_id, int dir_fd, ThreadStats& stats, std::deque<InFlight>& in_flight) {
+        const PathArena& paths = pass.thread_paths[thread_id];
+        size_t named = 0; // Files [0, named) have durable directory entries
+        size_t created = 0;
+        auto retire_oldest = [&]() {
+            InFlight file = in_flight.front();
+            in_flight.pop_front();
+            bool ok = fdatasync(file.fd) == 0;
+            if (ok && file.index >= named) {
+                ok = fsync(dir_fd) == 0;
+                named = created;
+            }
+            stats.durable.record(now_ns() - file.opened);
+            close(file.fd);
+            return ok;
+        };
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            uint64_t opened = now_ns();
+            int fd = open(paths[i], O_CREAT | O_EXCL | O_WRONLY, 0644);
+            if (fd < 0) return fail(stats, std::string("create of ") + paths[i] + " failed");
+            created++;
+            if (write(fd, data.data(), pass.file_size) != static_cast<ssize_t>(pass.file_size)) {
+                close(fd);
+                return fail(stats, std::string("write of ") + paths[i] + " failed");
+            }
+            progress_add(pass.file_size);
+            switch (pass.strategy) {
+                case Strategy::FDATASYNC:
+                    if (fdatasync(fd) != 0) {
+                        close(fd);
+                        return fail(stats, std::string("fdatasync of ") + paths[i] + " failed");
+                    }
+                    if (fsync(dir_fd) != 0) {
+                        close(fd);
+                        return fail(stats, std::string("fsync of the directory of ") + paths[i] + " failed");
+                    }
+                    stats.durable.record(now_ns() - opened);
+                    close(fd);
+                    break;
+                case Strategy::SYNC_FILE_RANGE:
+                    if (sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE) != 0) {
+                        close(fd);
+                        return fail(stats, std::string("sync_file_range of ") + paths[i] + " failed");
+                    }
+                    in_flight.push_back({fd, opened, i});
+                    if (in_flight.size() > pipeline_depth && !retire_oldest()) return fail(stats, "fdatasync or directory fsync failed");
+                    break;
+                case Strategy::SYNCFS:
+                case Strategy::NONE:
+                    close(fd);
+                    stats.pending.push_back(opened);
+                    if (pass.strategy == Strategy::SYNCFS && stats.pending.size() >= syncfs_batch) {
+                        if (!sync_filesystem()) return fail(stats, "syncfs failed");
+                        settle(stats);
+                    }
+                    break;
+            }
+        }
+        while (!in_flight.empty()) {
+            if (!retire_oldest()) return fail(stats, "fdatasync or directory fsync failed");
+        }
+        if (pass.strategy == Strategy::SYNCFS && !stats.pending.empty()) {
+            if (!sync_filesystem()) return fail(stats, "syncfs failed");
+            settle(stats);
+        }
+    }
+
+public:
+    explicit SmallFileDurableWriteBench(const TestContext& config): config(config) {
+        g_test_dir = get_param(config, "root", ".") + "/small_file_durable_write_bench";
+    }
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        std::filesystem::create_directories(g_test_dir);
+        worker_contexts = make_worker_contexts(config, "writer");
+        for (TestContext& context : worker_contexts) context.params["test_dir"] = g_test_dir.string();
+        return true;
+    }
+    void global_cleanup() {
+        std::filesystem::remove_all(g_test_dir);
+    }
+
+    bool worker_setup(const TestContext& context) {
+        num_threads = std::stoi(get_param(context, "num_threads", "4"));
+        size_t files_per_thread = std::stoul(get_param(context, "files_per_thread", "1000"));
+        syncfs_batch = std::stoul(get_param(context, "syncfs_batch", "100"));
+        pipeline_depth = std::stoul(get_param(context, "pipeline_depth", "16"));
+        if (num_threads <= 0 || syncfs_batch == 0) return false;
+
+        worker_dir = context.params.at("test_dir") + "/w" + std::to_string(context.worker_id);
+        std::error_code ec;
+        for (int t = 0; t < num_threads; ++t) {
+            std::filesystem::create_directories(worker_dir + "/t" + std::to_string(t), ec);
+            if (ec) return false;
+        }
+
+        passes.clear();
+        uint64_t largest = 0;
+        for (const std::string& name : split(get_param(context, "strategies", "fdatasync,syncfs,sync_file_range,none"))) {
+            Strategy strategy;
+            if (name == "fdatasync") strategy = Strategy::FDATASYNC;
+            else if (name == "syncfs") strategy = Strategy::SYNCFS;
+            else if (name == "sync_file_range") strategy = Strategy::SYNC_FILE_RANGE;
+            else if (name == "none") strategy = Strategy::NONE;
+            else return false;
+            for (const std::string& size : split(get_param(context, "file_sizes", "4k"))) {
+                Pass pass{strategy, parse_size(size), name + "_" + size, {}};
+                if (pass.file_size == 0) return false;
+                largest = std::max(largest, pass.file_size);
+                // <worker_dir>/t<thread>/<tag>.<i>: the tag keeps passes apart.
+                pass.thread_paths.resize(num_threads);
+                for (int t = 0; t < num_threads; ++t) {
+                    std::string prefix = worker_dir + "/t" + std::to_string(t) + "/" + pass.tag + ".";
+                    pass.thread_paths[t].reserve(files_per_thread, files_per_thread * (prefix.size() + 12));
+                    for (size_t i = 0; i < files_per_thread; ++i) pass.thread_paths[t].add(prefix, std::to_string(i));
+                }
+                passes.push_back(std::move(pass));
+            }
+        }
+        if (passes.empty() || !data.allocate(largest)) return false;
+        std::fill(data.begin(), data.end(), 'x');
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        passes.clear();
+        data.clear();
+        std::error_code ec;
+        std::filesystem::remove_all(worker_dir, ec);
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        ScopedTimer timer(result.duration_ns);
+        for (const Pass& pass : passes) {
+            std::vector<std::unique_ptr<ThreadStats>> stats(num_threads);
+            for (auto& s : stats) s = std::make_unique<ThreadStats>();
+            uint64_t start = now_ns();
+            bool synced = true;
+            {
+                RegionTimer region(result.regions[pass.tag]);
+                std::vector<std::thread> threads;
+                for (int i = 0; i < num_threads; ++i) threads.emplace_back([&, i] { run_thread(pass, i, *stats[i]); });
+                for (auto& t : threads) t.join();
+                if (pass.strategy == Strategy::NONE) {
+                    synced = sync_filesystem();
+                    for (auto& s : stats) settle(*s);
+                }
+                region.add_bytes(pass.file_size * pass.thread_paths[0].size() * num_threads);
+            }
+            double seconds = (now_ns() - start) / 1.0e9;
+            PERF_TEST_ASSERT(synced, pass.tag + ": syncfs failed", result);
+
+            LatencyHistogram& durable = result.histograms[pass.tag];
+            for (const auto& s : stats) {
+                PERF_TEST_ASSERT(s->ok, pass.tag + ": " + s->error, result);
+                durable.merge(s->durable);
+            }
+            result.metrics[pass.tag + "_files"] = durable.count();
+            result.metrics[pass.tag + "_s"] = seconds;
+            result.metrics[pass.tag + "_files_per_sec"] = durable.count() / seconds;
+            result.metrics[pass.tag + "_mib_per_sec"] = durable.count() * pass.file_size / MIB / seconds;
+            result.metrics[pass.tag + "_durable_p50_ms"] = durable.percentile(50.0) / 1.0e6;
+            result.metrics[pass.tag + "_durable_p99_ms"] = durable.percentile(99.0) / 1.0e6;
+            result.metrics[pass.tag + "_durable_max_ms"] = durable.max() / 1.0e6;
+
+            // Untimed: the next pass shouldn't pay for this one's space.
+            for (const PathArena& paths : pass.thread_paths) {
+                for (size_t i = 0; i < paths.size(); ++i) unlink(paths[i]);
+            }
+        }
+        result.success = true;
+        return result;
+    }
+};
+
+REGISTER_TEST("small_file_durable_write", [](const TestContext& config) {
+    return std::make_unique<SmallFileDurableWriteBench>(config);
+});
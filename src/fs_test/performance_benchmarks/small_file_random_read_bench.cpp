@@ -0,0 +1,279 @@
+#include "../test_common.hpp"
+#include "../io_uring_engine.hpp"
+#include "../path_arena.hpp"
+#include "../random_dist.hpp"
+
+#include <memory>
+#include <sys/resource.h>
+
+/**
+ * @brief Random 4 KiB read IOPS across a directory of small files
+ * (the native replacement for fio --rw=randread --directory=$SMALL_FILE_DIR).
+ *
+ * Every thread picks a file according to the popularity distribution, then a
+ * random block-aligned offset inside it, and reads one block. With iodepth > 1
+ * each thread keeps that many reads in flight through its own io_uring.
+ * All workers run at once through the normal setup / execute / cleanup flow.
+ *
+ * Params:
+ * - num_workers:   server only, workers to run on (default 1).
+ * - file_dir:      directory holding the files (the data plane's SMALL_FILE_DIR).
+ * - file_count:    number of files, named file_<i>.txt for i in [1, file_count] (default 100000).
+ * - file_size_kb:  size of every file (default 4).
+ * - block_size_kb: size of each read (default 4).
+ * - num_threads:   reader threads (default 8).
+ * - iodepth:       reads in flight per thread (default 1 = plain pread()).
+ * - fd_mode:       "cached" (default): every file is opened once in
+ *                  worker_setup; "open_per_read": open + read + close per read.
+ * - distribution:  "uniform" (default) or "zipf".
+ * - zipf_theta:    zipf skew (default 0.99, as in YCSB).
+ * - duration_s:    how long to read for (default 10).
+ * - direct:        1 to open with O_DIRECT (default 0).
+ */
+class SmallFileRandomReadBench: public BaseTest {
+private:
+    struct ThreadStats {
+        uint64_t reads = 0;
+        LatencyHistogram latency;
+        bool ok = true;
+        std::string error;
+    };
+
+    TestContext config;
+
+    PathArena paths;
+    std::vector<int> fds; // cached mode only
+    std::unique_ptr<ZipfPicker> zipf;
+    size_t file_count = 0;
+    size_t block_size = 4096;
+    uint64_t blocks_per_file = 1;
+    int num_threads = 8;
+    unsigned iodepth = 1;
+    bool cached_fds = true;
+    int open_flags = O_RDONLY;
+
+    size_t pick_file(FastRng& rng) const {
+        return zipf ? zipf->pick(rng.uniform()) : rng.next() % file_count;
+    }
+    uint64_t pick_offset(FastRng& rng) const {
+        return blocks_per_file > 1 ? (rng.next() % blocks_per_file) * block_size : 0;
+    }
+
+    /** @brief Returns the fd to read file i from, opening it if fds aren't cached. */
+    int acquire_fd(size_t i) const {
+        return cached_fds ? fds[i] : open(paths[i], open_flags);
+    }
+    void release_fd(int fd) const {
+        if (!cached_fds) close(fd);
+    }
+
+    /** @brief Queue depth 1: one blocking pread() at a time. */
+    void run_sync(int thread_id, uint64_t deadline_ns, ThreadStats& stats) {
+        AlignedBuffer buf(block_size);
+        FastRng rng{data_seed(thread_id)};
+        while (true) {
+            // Checking the clock every read would cost as much as a cached read.
+            if ((stats.reads & 63) == 0 && now_ns() >= deadline_ns) break;
+            size_t file = pick_file(rng);
+            uint64_t offset = pick_offset(rng);
+            uint64_t op_start = now_ns();
+            int fd = acquire_fd(file);
+            if (fd < 0) return fail(stats, "open() failed");
+            ssize_t n = pread(fd, buf.data(), block_size, offset);
+            release_fd(fd);
+            if (n <= 0) return fail(stats, "pread() failed");
+            stats.latency.record(now_ns() - op_start);
+            progress_add(n);
+            stats.reads++;
+        }
+    }
+
+    /** @brief Keeps `iodepth` reads in flight through a per-thread io_uring. */
+    void run_uring(int thread_id, uint64_t deadline_ns, ThreadStats& stats) {
+        IoUring ring;
+        if (!ring.init(iodepth)) return fail(stats, "io_uring_setup() failed");
+        unsigned depth = std::min(iodepth, ring.sq_entries());
+        std::vector<AlignedBuffer> buffers(depth);
+        std::vector<int> slot_fd(depth, -1);
+        std::vector<uint64_t> issue_ns(depth);
+        for (auto& buffer : buffers) {
+            if (!buffer.allocate(block_size)) return fail(stats, "buffer allocation failed");
+        }
+        FastRng rng{data_seed(thread_id)};
+
+        // After an error, stop issuing but keep reaping until nothing is in
+        // flight: returning early would free buffers the kernel still reads
+        // into and, in open_per_read mode, leak the fds of those reads.
+        unsigned inflight = 0;
+        bool draining = false;
+        std::vector<unsigned> pending; // Slots prepared since the last submit
+        auto stop = [&](const char* msg) {
+            if (stats.ok) fail(stats, msg);
+            draining = true;
+        };
+        auto issue = [&](unsigned slot) {
+            size_t file = pick_file(rng);
+            issue_ns[slot] = now_ns(); // Includes the open() in open_per_read mode
+            slot_fd[slot] = acquire_fd(file);
+            if (slot_fd[slot] < 0) return stop("open() failed");
+            io_uring_sqe* sqe = ring.get_sqe();
+            IoUring::prep_read(sqe, slot_fd[slot], buffers[slot].data(), block_size, pick_offset(rng), slot);
+            pending.push_back(slot);
+            ++inflight;
+        };
+        auto submit = [&] {
+            if (pending.empty()) return;
+            if (ring.submit() < 0) {
+                // The kernel took none of them, so none will complete.
+                stop("io_uring_enter() failed");
+                for (unsigned slot : pending) release_fd(slot_fd[slot]);
+                inflight -= pending.size();
+            }
+            pending.clear();
+        };
+
+        for (unsigned slot = 0; slot < depth && !draining; ++slot) issue(slot);
+        submit();
+
+        while (inflight > 0) {
+            io_uring_cqe* cqe = ring.wait_cqe();
+            if (!cqe) return fail(stats, "io_uring wait failed"); // The ring itself is broken
+            if (!draining && now_ns() >= deadline_ns) draining = true;
+            while (cqe) {
+                unsigned slot = static_cast<unsigned>(cqe->user_data);
+                int res = cqe->res;
+                ring.cqe_seen();
+                release_fd(slot_fd[slot]);
+                --inflight;
+                if (res <= 0) {
+                    errno = res < 0 ? -res : EIO;
+                    stop("io_uring read failed");
+                } else {
+                    stats.latency.record(now_ns() - issue_ns[slot]);
+                    progress_add(res);
+                    stats.reads++;
+                }
+                if (!draining) issue(slot);
+                cqe = ring.peek_cqe();
+            }
+            submit();
+        }
+    }
+
+    uint64_t data_seed(int thread_id) const {
+        return 0x9e3779b97f4a7c15ull * (config.worker_id + 1) + 0xbf58476d1ce4e5b9ull * (thread_id + 1);
+    }
+
+    static void fail(ThreadStats& stats, const std::string& msg) {
+        stats.ok = false;
+        stats.error = msg + " (errno: " + get_error_str() + ")";
+    }
+
+public:
+    explicit SmallFileRandomReadBench(const TestContext& config): config(config) {}
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        if (!std::filesystem::is_directory(get_param(config, "file_dir", ""))) return false;
+        worker_contexts = make_worker_contexts(config, "reader");
+        return true;
+    }
+    void global_cleanup() {}
+
+    bool worker_setup(const TestContext& context) {
+        config = context;
+        std::string file_dir = context.params.at("file_dir");
+        file_count = std::stoul(get_param(context, "file_count", "100000"));
+        block_size = std::stoul(get_param(context, "block_size_kb", "4")) * 1024;
+        uint64_t file_size = std::stoull(get_param(context, "file_size_kb", "4")) * 1024;
+        num_threads = std::stoi(get_param(context, "num_threads", "8"));
+        iodepth = std::stoul(get_param(context, "iodepth", "1"));
+        std::string fd_mode = get_param(context, "fd_mode", "cached");
+        if (fd_mode != "cached" && fd_mode != "open_per_read") return false;
+        cached_fds = fd_mode == "cached";
+        open_flags = O_RDONLY | (get_param(context, "direct", "0") == "1" ? O_DIRECT : 0);
+        if (file_count == 0 || block_size == 0 || file_size < block_size || num_threads <= 0 || iodepth == 0) return false;
+        blocks_per_file = file_size / block_size;
+
+        std::string dist = get_param(context, "distribution", "uniform");
+        if (dist == "zipf") {
+            double theta = std::stod(get_param(context, "zipf_theta", "0.99"));
+            zipf = std::make_unique<ZipfPicker>(file_count, theta, context.worker_id + 1);
+        } else if (dist == "uniform") {
+            zipf.reset();
+        } else {
+            return false;
+        }
+
+        paths.clear();
+        paths.reserve(file_count, file_count * (file_dir.size() + 20));
+        for (size_t i = 1; i <= file_count; ++i) paths.add(file_dir, "/file_" + std::to_string(i) + ".txt");
+
+        if (!cached_fds) return true;
+        // Caching 100k fds needs a raised RLIMIT_NOFILE; take whatever the hard limit allows.
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < file_count + 64) {
+            limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, file_count + 64);
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+        fds.assign(file_count, -1);
+        for (size_t i = 0; i < file_count; ++i) {
+            fds[i] = open(paths[i], open_flags);
+            if (fds[i] < 0) return false;
+        }
+        return true;
+    }
+    void worker_cleanup(const TestContext& context) {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+        fds.clear();
+        paths.clear();
+        zipf.reset();
+    }
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        PERF_TEST_ASSERT(paths.size() == file_count, "Paths not built (setup failed?)", result);
+        double duration_s = std::stod(get_param(context, "duration_s", "10"));
+
+        std::vector<std::unique_ptr<ThreadStats>> stats(num_threads);
+        for (auto& s : stats) s = std::make_unique<ThreadStats>();
+
+        std::vector<std::thread> threads;
+        {
+            ScopedTimer timer(result.duration_ns);
+            RegionTimer region(result.regions["random_read"]);
+            uint64_t deadline = now_ns() + static_cast<uint64_t>(duration_s * 1e9);
+            for (int i = 0; i < num_threads; ++i) {
+                threads.emplace_back([&, i] {
+                    if (iodepth > 1) run_uring(i, deadline, *stats[i]);
+                    else run_sync(i, deadline, *stats[i]);
+                });
+            }
+            for (auto& t : threads) t.join();
+            uint64_t reads = 0;
+            for (const auto& s : stats) reads += s->reads;
+            region.add_bytes(reads * block_size);
+        }
+
+        uint64_t reads = 0;
+        for (const auto& s : stats) {
+            PERF_TEST_ASSERT(s->ok, s->error, result);
+            reads += s->reads;
+            result.histograms["read"].merge(s->latency);
+        }
+        double elapsed_s = result.duration_ns / 1.0e9;
+        result.success = true;
+        result.metrics["reads"] = reads;
+        result.metrics["iops"] = reads / elapsed_s;
+        result.metrics["read_mib_per_sec"] = reads * block_size / (1024.0 * 1024.0) / elapsed_s;
+        result.metrics["num_threads"] = num_threads;
+        result.metrics["iodepth"] = iodepth;
+        result.metrics["fd_mode"] = cached_fds ? "cached" : "open_per_read";
+        result.metrics["distribution"] = zipf ? "zipf" : "uniform";
+        return result;
+    }
+};
+
+REGISTER_TEST("small_file_random_read", [](const TestContext& config) {
+    return std::make_unique<SmallFileRandomReadBench>(config);
+});
@@ -0,0 +1,273 @@
+#include "../test_common.hpp"
+#include "../work_stealing.hpp"
+
+#include <algorithm>
+#include <dirent.h> // DT_* constants
+#include <memory>
+#include <sys/syscall.h>
+
+/**
+ * @brief Parallel directory-tree traversal (the native replacement for
+ * `find $SMALL_FILE_DIR -type f | wc -l`).
+ *
+ * Directories are read with raw getdents64 into a large per-thread buffer,
+ * so a directory of thousands of entries takes a handful of syscalls, by a
+ * WorkStealingPool that queues the subdirectories each read finds. With
+ * statx_mask set, every entry is also statx()ed, as `find -size` or a
+ * scanner would.
+ *
+ * The walk runs once per thread count. Every worker walks the same tree, so
+ * running on all workers at once measures the filesystem under concurrent
+ * scans of one namespace.
+ *
+ * Params:
+ * - num_workers:    server only, workers to run on (default 1).
+ * - root:           tree to walk (e.g. the data plane's SMALL_FILE_DIR).
+ * - walk_threads:   comma-separated thread counts (default "1,4,16").
+ * - getdents_kb:    getdents64 buffer size (default 256).
+ * - statx_mask:     comma-separated fields to statx() every entry for:
+ *                   type, mode, nlink, uid, gid, atime, mtime, ctime, ino,
+ *                   size, blocks, btime, basic or all. Empty (default) = no
+ *                   statx, only d_type from getdents64.
+ * - statx_sync:     "as_stat" (default), "force" or "dont_sync"
+ *                   (AT_STATX_SYNC_AS_STAT / FORCE_SYNC / DONT_SYNC).
+ * - warmup:         1 (default) to walk once untimed first, so every thread
+ *                   count sees the same (warm) client caches; 0 to time a
+ *                   possibly cold first walk.
+ */
+class TreeWalkBench: public BaseTest {
+private:
+    /** @brief Layout of one getdents64 record (struct linux_dirent64). */
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    struct Stats {
+        uint64_t dirs = 0;
+        uint64_t entries = 0; // Everything but . and ..
+        uint64_t files = 0;
+        uint64_t getdents_calls = 0;
+        uint64_t statx_calls = 0;
+        LatencyHistogram dir_read; // open + getdents64 to the end + close, per directory
+        LatencyHistogram statx;
+    };
+
+    /** @brief One timed walk with a fixed number of threads. */
+    class Walker {
+    public:
+        Walker(int num_threads, size_t buffer_size, unsigned statx_mask, int statx_flags)
+            : num_threads_(num_threads), buffer_size_(buffer_size),
+              statx_mask_(statx_mask), statx_flags_(statx_flags), pool_(num_threads) {}
+
+        bool walk(const std::string& root, Stats& total) {
+            std::vector<std::unique_ptr<ThreadState>> states(num_threads_);
+            for (auto& state : states) {
+                state = std::make_unique<ThreadState>();
+                if (!state->buffer.allocate(buffer_size_)) return fail("buffer allocation failed");
+            }
+            bool ok = pool_.run(root, [&](int self, const std::string& dir) {
+                return read_dir(self, dir, *states[self]);
+            });
+            if (!ok) return false;
+
+            for (const auto& state : states) {
+                const Stats& s = state->stats;
+                total.dirs += s.dirs;
+                total.entries += s.entries;
+                total.files += s.files;
+                total.getdents_calls += s.getdents_calls;
+                total.statx_calls += s.statx_calls;
+                total.dir_read.merge(s.dir_read);
+                total.statx.merge(s.statx);
+            }
+            return true;
+        }
+
+        const std::string& error() const { return error_; }
+
+    private:
+        struct ThreadState {
+            Stats stats;
+            AlignedBuffer buffer; // getdents64 records
+        };
+
+        bool read_dir(int self, const std::string& path, ThreadState& state) {
+            AlignedBuffer& buffer = state.buffer;
+            Stats& stats = state.stats;
+            uint64_t start = now_ns();
+            uint64_t statx_ns = 0;
+            int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) return fail("open() failed for " + path);
+            uint64_t entries = 0;
+            while (true) {
+                long n = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+                stats.getdents_calls++;
+                if (n < 0) {
+                    close(fd);
+                    return fail("getdents64() failed for " + path);
+                }
+                if (n == 0) break;
+                for (long pos = 0; pos < n;) {
+                    auto entry = reinterpret_cast<const LinuxDirent64*>(buffer.data() + pos);
+                    pos += entry->d_reclen;
+                    const char* name = entry->d_name;
+                    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                    entries++;
+
+                    unsigned char type = entry->d_type;
+                    if (statx_mask_ || type == DT_UNKNOWN) {
+                        struct statx stx;
+                        uint64_t op_start = now_ns();
+                        int rc = ::statx(fd, name, AT_SYMLINK_NOFOLLOW | statx_flags_,
+                                         statx_mask_ | STATX_TYPE, &stx);
+                        uint64_t op_ns = now_ns() - op_start;
+                        stats.statx.record(op_ns);
+                        stats.statx_calls++;
+                        statx_ns += op_ns;
+                        if (rc != 0) {
+                            // Deleted under us by a concurrent writer; not an error for a scanner.
+                            if (errno == ENOENT) continue;
+                            close(fd);
+                            return fail("statx() failed in " + path);
+                        }
+                        type = S_ISDIR(stx.stx_mode) ? DT_DIR : S_ISREG(stx.stx_mode) ? DT_REG : DT_UNKNOWN;
+                    }
+                    if (type == DT_DIR) pool_.push(self, path + "/" + name);
+                    else if (type == DT_REG) stats.files++;
+                }
+            }
+            close(fd);
+            // Directory read latency excludes the per-entry statx calls, which have their own histogram.
+            stats.dir_read.record(now_ns() - start - statx_ns);
+            stats.dirs++;
+            stats.entries += entries;
+            progress_add(0, entries);
+            return true;
+        }
+
+        bool fail(const std::string& msg) {
+            std::lock_guard<std::mutex> lock(error_mtx_);
+            if (error_.empty()) error_ = msg + " (errno: " + get_error_str() + ")";
+            return false;
+        }
+
+        const int num_threads_;
+        const size_t buffer_size_;
+        const unsigned statx_mask_;
+        const int statx_flags_;
+        WorkStealingPool<std::string> pool_;
+        std::mutex error_mtx_;
+        std::string error_;
+    };
+
+    TestContext config;
+    std::vector<int> thread_counts;
+    size_t buffer_size = 256 * 1024;
+    unsigned statx_mask = 0;
+    int statx_flags = AT_STATX_SYNC_AS_STAT;
+    bool warmup = true;
+
+    /** @return false on an unknown field name. */
+    static bool parse_statx_mask(const std::string& list, unsigned& mask) {
+        static const std::map<std::string, unsigned> FIELDS = {
+            {"type", STATX_TYPE}, {"mode", STATX_MODE}, {"nlink", STATX_NLINK},
+            {"uid", STATX_UID}, {"gid", STATX_GID}, {"atime", STATX_ATIME},
+            {"mtime", STATX_MTIME}, {"ctime", STATX_CTIME}, {"ino", STATX_INO},
+            {"size", STATX_SIZE}, {"blocks", STATX_BLOCKS}, {"btime", STATX_BTIME},
+            {"basic", STATX_BASIC_STATS}, {"all", STATX_ALL},
+        };
+        mask = 0;
+        for (const std::string& field : split(list)) {
+            auto it = FIELDS.find(field);
+            if (it == FIELDS.end()) return false;
+            mask |= it->second;
+        }
+        return true;
+    }
+
+public:
+    explicit TreeWalkBench(const TestContext& config): config(config) {}
+
+    bool global_setup(std::vector<TestContext>& worker_contexts) {
+        if (!std::filesystem::is_directory(get_param(config, "root", ""))) return false;
+        worker_contexts = make_worker_contexts(config, "walker");
+        return true;
+    }
+    void global_cleanup() {}
+
+    bool worker_setup(const TestContext& context) {
+        config = context;
+        if (!std::filesystem::is_directory(get_param(context, "root", ""))) return false;
+        thread_counts.clear();
+        for (const std::string& count : split(get_param(context, "walk_threads", "1,4,16"))) {
+            int threads = std::stoi(count);
+            if (threads <= 0) return false;
+            thread_counts.push_back(threads);
+        }
+        // getdents64 needs room for at least one maximal record.
+        buffer_size = std::max<size_t>(4, std::stoul(get_param(context, "getdents_kb", "256"))) * 1024;
+        if (!parse_statx_mask(get_param(context, "statx_mask", ""), statx_mask)) return false;
+
+        std::string sync = get_param(context, "statx_sync", "as_stat");
+        if (sync == "as_stat") statx_flags = AT_STATX_SYNC_AS_STAT;
+        else if (sync == "force") statx_flags = AT_STATX_FORCE_SYNC;
+        else if (sync == "dont_sync") statx_flags = AT_STATX_DONT_SYNC;
+        else return false;
+        warmup = get_param(context, "warmup", "1") == "1";
+        return !thread_counts.empty();
+    }
+    void worker_cleanup(const TestContext& context) {}
+    TestResult worker_execute(const TestContext& context) {
+        TestResult result;
+        std::string root = context.params.at("root");
+        PERF_TEST_ASSERT(!thread_counts.empty(), "No thread counts (setup failed?)", result);
+
+        if (warmup) {
+            auto stats = std::make_unique<Stats>();
+            Walker walker(*std::max_element(thread_counts.begin(), thread_counts.end()),
+                          buffer_size, statx_mask, statx_flags);
+            PERF_TEST_ASSERT(walker.walk(root, *stats), "warmup: " + walker.error(), result);
+        }
+
+        uint64_t start_ns = now_ns();
+        for (int threads : thread_counts) {
+            std::string tag = "walk_t" + std::to_string(threads);
+            auto stats = std::make_unique<Stats>();
+            Walker walker(threads, buffer_size, statx_mask, statx_flags);
+            uint64_t time_ns;
+            bool ok;
+            {
+                ScopedTimer timer(time_ns);
+                RegionTimer region(result.regions[tag]);
+                ok = walker.walk(root, *stats);
+            }
+            PERF_TEST_ASSERT(ok, tag + ": " + walker.error(), result);
+
+            double time_s = time_ns / 1.0e9;
+            result.metrics[tag + "_s"] = time_s;
+            result.metrics[tag + "_entries_per_sec"] = stats->entries / time_s;
+            result.metrics[tag + "_dirs_per_sec"] = stats->dirs / time_s;
+            result.metrics[tag + "_getdents_calls"] = stats->getdents_calls;
+            result.metrics[tag + "_statx_calls"] = stats->statx_calls;
+            result.histograms["dir_read_" + tag].merge(stats->dir_read);
+            if (stats->statx.count()) result.histograms["statx_" + tag].merge(stats->statx);
+            result.metrics["entries"] = stats->entries;
+            result.metrics["files"] = stats->files;
+            result.metrics["dirs"] = stats->dirs;
+        }
+        result.duration_ns = now_ns() - start_ns;
+
+        result.success = true;
+        result.metrics["getdents_kb"] = buffer_size / 1024;
+        result.metrics["statx_mask"] = get_param(context, "statx_mask", "");
+        return result;
+    }
+};
+
+REGISTER_TEST("tree_walk", [](const TestContext& config) {
+    return std::make_unique<TreeWalkBench>(config);
+});
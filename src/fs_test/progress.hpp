@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "../comm_utils/clock.hpp"
+
+/**
+ * @brief Process-wide bytes / ops counters that benchmarks bump from their
+ * hot loops, so a sampler can report progress while a test runs.
+ *
+ * Counters are split into cache-line-sized shards and every thread sticks
+ * to one, so add() is an uncontended relaxed fetch_add in the common case
+ * (up to SHARDS threads). Readers sum the shards.
+ */
+class ProgressCounters {
+public:
+    static ProgressCounters& instance() {
+        static ProgressCounters counters;
+        return counters;
+    }
+
+    void add(uint64_t bytes, uint64_t ops) {
+        Shard& shard = shards_[shard_index()];
+        shard.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        shard.ops.fetch_add(ops, std::memory_order_relaxed);
+    }
+
+    void snapshot(uint64_t& bytes, uint64_t& ops) const {
+        bytes = ops = 0;
+        for (const Shard& shard : shards_) {
+            bytes += shard.bytes.load(std::memory_order_relaxed);
+            ops += shard.ops.load(std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        for (Shard& shard : shards_) {
+            shard.bytes.store(0, std::memory_order_relaxed);
+            shard.ops.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> ops{0};
+    };
+
+    static size_t shard_index() {
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+
+    Shard shards_[SHARDS];
+};
+
+/**
+ * @brief Records `bytes` moved by `ops` operations in the live progress counters.
+ * Cheap enough to call once per I/O.
+ */
+inline void progress_add(uint64_t bytes, uint64_t ops = 1) {
+    ProgressCounters::instance().add(bytes, ops);
+}
+
+
+/**
+ * @brief Background thread that snapshots ProgressCounters every interval
+ * and hands the cumulative totals to a callback.
+ *
+ * Resets the counters on start; stop() takes one last sample, so the final
+ * sample always holds the run's totals.
+ */
+class ProgressSampler {
+public:
+    /** @brief (CLOCK_REALTIME ns, cumulative bytes, cumulative ops) */
+    using Callback = std::function<void(uint64_t t_ns, uint64_t bytes, uint64_t ops)>;
+
+    ProgressSampler(std::chrono::milliseconds interval, Callback callback)
+        : interval_(interval), callback_(std::move(callback)) {
+        ProgressCounters::instance().reset();
+        thread_ = std::thread([this] { run(); });
+    }
+    ~ProgressSampler() { stop(); }
+
+    ProgressSampler(const ProgressSampler&) = delete;
+    ProgressSampler& operator=(const ProgressSampler&) = delete;
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (stopped_) return;
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        sample();
+    }
+
+private:
+    void run() {
+        auto next = std::chrono::steady_clock::now() + interval_;
+        std::unique_lock<std::mutex> lock(mtx_);
+        // Ticks are scheduled from the start, not from the last wakeup, so
+        // samples don't drift later over a long run.
+        while (!cv_.wait_until(lock, next, [this] { return stopped_; })) {
+            lock.unlock();
+            sample();
+            lock.lock();
+            next += interval_;
+        }
+    }
+
+    void sample() {
+        uint64_t bytes, ops;
+        ProgressCounters::instance().snapshot(bytes, ops);
+        callback_(realtime_ns(), bytes, ops);
+    }
+
+    std::chrono::milliseconds interval_;
+    Callback callback_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopped_ = false;
+    std::thread thread_;
+};
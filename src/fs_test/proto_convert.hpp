@@ -0,0 +1,133 @@
+#pragma once
+
+// Conversions between the plain structs in base_test_types.hpp and the
+// protobuf messages that carry them over the Comm stream.
+
+#include <limits>
+
+#include "base_test_types.hpp"
+#include "../../protos/hpcfs_bench.pb.h"
+
+inline void to_proto(const LatencyHistogram& hist, hpcfs_bench::LatencyHistogram* out) {
+    out->set_sub_bucket_bits(LatencyHistogram::SUB_BUCKET_BITS);
+    out->set_count(hist.count());
+    out->set_sum(hist.sum());
+    out->set_min(hist.min());
+    out->set_max(hist.max());
+    std::vector<int64_t> encoded = hist.encode_counts();
+    out->mutable_counts()->Assign(encoded.begin(), encoded.end());
+}
+
+/**
+ * @return false if the message was produced with a different bucket layout
+ * or is malformed.
+ */
+inline bool from_proto(const hpcfs_bench::LatencyHistogram& msg, LatencyHistogram& out) {
+    if (msg.sub_bucket_bits() != LatencyHistogram::SUB_BUCKET_BITS) return false;
+    return out.decode_counts(msg.counts().begin(), msg.counts().end(),
+                             msg.count(), msg.sum(), msg.min(), msg.max());
+}
+
+
+inline void to_proto(const TestContext& context, hpcfs_bench::TestParams* out) {
+    out->set_worker_id(context.worker_id);
+    out->set_total_workers(context.total_workers);
+    out->set_role(context.role);
+    out->set_iteration(context.iteration);
+    out->mutable_params()->clear();
+    for (const auto& [key, value] : context.params) (*out->mutable_params())[key] = value;
+}
+
+inline void from_proto(const hpcfs_bench::TestParams& msg, TestContext& out) {
+    out.worker_id = msg.worker_id();
+    out.total_workers = msg.total_workers();
+    out.role = msg.role();
+    out.iteration = msg.iteration();
+    out.params.clear();
+    for (const auto& [key, value] : msg.params()) out.params[key] = value;
+}
+
+inline void to_proto(const Metric& metric, hpcfs_bench::Metric* out) {
+    switch (metric.type()) {
+        case Metric::Type::INT: out->set_int_value(metric.as_int()); break;
+        case Metric::Type::DOUBLE: out->set_double_value(metric.as_double()); break;
+        case Metric::Type::TEXT: out->set_text(metric.text()); break;
+        case Metric::Type::INT_ARRAY:
+            out->mutable_ints()->mutable_values()->Assign(metric.ints().begin(), metric.ints().end());
+            break;
+        case Metric::Type::DOUBLE_ARRAY:
+            out->mutable_doubles()->mutable_values()->Assign(metric.doubles().begin(), metric.doubles().end());
+            break;
+    }
+    if (!metric.unit().empty()) out->set_unit(metric.unit());
+}
+
+/**
+ * @param name Used for the implied unit when the message carries none.
+ */
+inline Metric from_proto(const hpcfs_bench::Metric& msg, const std::string& name) {
+    Metric metric;
+    switch (msg.value_case()) {
+        case hpcfs_bench::Metric::kIntValue: metric = msg.int_value(); break;
+        case hpcfs_bench::Metric::kDoubleValue: metric = msg.double_value(); break;
+        case hpcfs_bench::Metric::kText: metric = msg.text(); break;
+        case hpcfs_bench::Metric::kInts:
+            metric = std::vector<int64_t>(msg.ints().values().begin(), msg.ints().values().end());
+            break;
+        case hpcfs_bench::Metric::kDoubles:
+            metric = std::vector<double>(msg.doubles().values().begin(), msg.doubles().values().end());
+            break;
+        case hpcfs_bench::Metric::VALUE_NOT_SET: break;
+    }
+    metric.set_unit(msg.unit().empty() ? metric_unit_for(name) : msg.unit());
+    return metric;
+}
+
+/**
+ * @brief A scalar metric straight off the wire, for aggregating over many
+ * results without converting them: NaN for text, arrays and unset values.
+ */
+inline double metric_value(const hpcfs_bench::Metric& msg) {
+    switch (msg.value_case()) {
+        case hpcfs_bench::Metric::kIntValue: return static_cast<double>(msg.int_value());
+        case hpcfs_bench::Metric::kDoubleValue: return msg.double_value();
+        default: return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+inline void to_proto(const TestResult& result, hpcfs_bench::TestResult* out) {
+    out->set_correct(result.success);
+    out->set_duration(result.duration_ns);
+    out->set_message(result.error_msg);
+    for (const auto& [key, value] : result.metrics) to_proto(value, &(*out->mutable_metrics())[key]);
+    for (const auto& [name, hist] : result.histograms) to_proto(hist, &(*out->mutable_histograms())[name]);
+    for (const auto& [name, region] : result.regions) {
+        hpcfs_bench::TimedRegion& msg = (*out->mutable_regions())[name];
+        msg.set_start_ns(region.start_ns);
+        msg.set_end_ns(region.end_ns);
+        msg.set_bytes(region.bytes);
+    }
+    for (const ProgressSample& sample : result.timeline) {
+        hpcfs_bench::ProgressSample* msg = out->add_timeline();
+        msg->set_t_ns(sample.t_ns);
+        msg->set_bytes(sample.bytes);
+        msg->set_ops(sample.ops);
+    }
+}
+
+/**
+ * @return false if any histogram failed to decode (the rest is still converted).
+ */
+inline bool from_proto(const hpcfs_bench::TestResult& msg, TestResult& out) {
+    out.success = msg.correct();
+    out.duration_ns = msg.duration();
+    out.error_msg = msg.message();
+    for (const auto& [key, value] : msg.metrics()) out.metrics[key] = from_proto(value, key);
+    for (const auto& [name, region] : msg.regions()) {
+        out.regions[name] = {region.start_ns(), region.end_ns(), region.bytes()};
+    }
+    for (const auto& sample : msg.timeline()) out.timeline.push_back({sample.t_ns(), sample.bytes(), sample.ops()});
+    bool ok = true;
+    for (const auto& [name, hist] : msg.histograms()) ok &= from_proto(hist, out.histograms[name]);
+    return ok;
+}
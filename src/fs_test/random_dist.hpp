@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+/** @brief Per-thread xorshift64*; std::mt19937 would dominate a cached-I/O loop. */
+struct FastRng {
+    uint64_t state;
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dull;
+    }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+
+/**
+ * @brief Zipfian item picker (Gray et al., as used by YCSB).
+ *
+ * pick() is O(1); only the zeta constant needs a pass over all N items,
+ * which happens once at construction. Ranks are mapped through a fixed
+ * random permutation so the hot items are spread out rather than being
+ * items 0, 1, 2, ...
+ */
+class ZipfPicker {
+public:
+    ZipfPicker() = default;
+    ZipfPicker(size_t n, double theta, uint64_t seed): n_(n), theta_(theta), permutation_(n) {
+        double zeta_n = 0;
+        for (size_t i = 1; i <= n; ++i) zeta_n += 1.0 / std::pow(static_cast<double>(i), theta);
+        double zeta_2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        alpha_ = 1.0 / (1.0 - theta);
+        zeta_n_ = zeta_n;
+        eta_ = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n);
+        std::iota(permutation_.begin(), permutation_.end(), 0);
+        std::shuffle(permutation_.begin(), permutation_.end(), std::mt19937_64(seed));
+    }
+
+    /** @param u Uniform in [0, 1). */
+    size_t pick(double u) const {
+        double uz = u * zeta_n_;
+        size_t rank;
+        if (uz < 1.0) rank = 0;
+        else if (uz < 1.0 + std::pow(0.5, theta_)) rank = 1;
+        else rank = static_cast<size_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return permutation_[std::min(rank, n_ - 1)];
+    }
+
+    size_t size() const { return n_; }
+
+private:
+    size_t n_ = 1;
+    double theta_ = 0;
+    double alpha_ = 0, zeta_n_ = 1, eta_ = 0;
+    std::vector<uint32_t> permutation_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "base_test_types.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Folds one GrpcClientManager::run_all() round into per-worker totals.
+ *
+ * For tests whose global_execute() runs several synchronized rounds (one per
+ * block size, phase, worker count, ...) but must still return one TestResult
+ * per worker. round[i] is merged into merged[i], so a round may cover just
+ * the first workers. The tag should be what the workers prefix their own
+ * metric, region and histogram names with; metrics without it (e.g. the
+ * start_late_ns the client manager adds) get it prepended so rounds don't
+ * overwrite each other. The first failure is kept, tagged with its round.
+ */
+inline void merge_round(std::vector<TestResult>& merged, const std::vector<TestResult>& round, const std::string& tag) {
+    for (size_t w = 0; w < round.size() && w < merged.size(); ++w) {
+        const TestResult& r = round[w];
+        TestResult& out = merged[w];
+        if (!r.success && out.success) {
+            out.success = false;
+            out.error_msg = tag + ": " + r.error_msg;
+        }
+        out.duration_ns += r.duration_ns;
+        for (const auto& [key, value] : r.metrics) {
+            out.metrics[key.compare(0, tag.size(), tag) == 0 ? key : tag + "_" + key] = value;
+        }
+        for (const auto& [name, hist] : r.histograms) out.histograms[name].merge(hist);
+        for (const auto& [name, region] : r.regions) out.regions[name] = region;
+        out.timeline.insert(out.timeline.end(), r.timeline.begin(), r.timeline.end());
+    }
+}
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <sstream>
+#include <cctype>
 #include <thread>
 #include <chrono>
 #include <mutex>
@@ -13,18 +15,25 @@
 #include <filesystem> // For C++17 filesystem operations
 
 // --- C POSIX Libs ---
+#include <sys/resource.h> // for getrusage
 #include <sys/stat.h>
+#include <sys/syscall.h>  // for SYS_perf_event_open
 #include <sys/types.h>
 #include <sys/file.h> // for flock
 #include <fcntl.h>    // for open, O_DIRECT
 #include <unistd.h>   // for link, symlink, unlink, read, write, close, lseek
 #include <errno.h>    // for errno
 #include <string.h>   // for strerror
-#include <cstdlib>    // for system()
+#include <cstdlib>    // for system(), posix_memalign()
+#include <linux/perf_event.h>
 
 // --- Project Headers ---
 #include "base_test.hpp"
-#include "base_test_types.hpp" // todo: replace with protobuf-defined types or implement a converter
+#include "base_test_types.hpp" // Plain structs; proto_convert.hpp maps them to the wire types
+#include "test_registry.hpp"
+#include "progress.hpp"
+#include "aligned_buffer.hpp"
+#include "../comm_utils/clock.hpp"
 
 // --- Helper Functions ---
 #define TEST_ASSERT(cond, msg, result_obj) \
@@ -48,6 +57,52 @@ inline std::string get_error_str() {
 }
 
 
+/**
+ * @brief Returns context.params[key], or fallback if the key is absent.
+ */
+inline std::string get_param(const TestContext& context, const std::string& key, const std::string& fallback) {
+    auto it = context.params.find(key);
+    return (it == context.params.end()) ? fallback : it->second;
+}
+
+/**
+ * @brief One context per worker for tests where every worker gets the same
+ * job: worker i of the "num_workers" param (default 1), all with `role` and
+ * a copy of config.params. Callers add per-worker params afterwards.
+ */
+inline std::vector<TestContext> make_worker_contexts(const TestContext& config, const std::string& role) {
+    int num_workers = std::stoi(get_param(config, "num_workers", "1"));
+    std::vector<TestContext> contexts;
+    for (int i = 0; i < num_workers; ++i) contexts.push_back({i, num_workers, role, config.params});
+    return contexts;
+}
+
+/**
+ * @brief Splits a comma-separated param value ("1,8,64") into its items.
+ */
+inline std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) items.push_back(item);
+    return items;
+}
+
+/**
+ * @brief Parses a byte count with an optional k/m/g suffix (binary units), e.g. "64k".
+ */
+inline uint64_t parse_size(const std::string& text) {
+    size_t end;
+    uint64_t value = std::stoull(text, &end);
+    switch (end < text.size() ? std::tolower(text[end]) : 0) {
+        case 'k': return value << 10;
+        case 'm': return value << 20;
+        case 'g': return value << 30;
+        default: return value;
+    }
+}
+
+
 /**
  * @brief Simple RAII timer.
  * Usage:
@@ -74,3 +129,163 @@ private:
     uint64_t& duration_out_;
 };
 
+
+/**
+ * @brief What the OS charged to a stretch of code: CPU time, context
+ * switches, page faults, storage I/O and, where perf_event_open() is
+ * allowed, user-space cycles and instructions.
+ *
+ * Wall time alone can't tell a slow filesystem from a client burning CPU.
+ * The worker agent wraps every worker_execute() in a PROCESS scope, so every
+ * result carries the "os_*" metrics; a bench can add its own around a phase.
+ * PROCESS counts the threads the code starts (they must be joined before
+ * report()) but also anything else running in the process; THREAD counts
+ * the calling thread only.
+ * Usage:
+ * {
+ * ResourceScope usage(ResourceScope::THREAD);
+ * // ... code to measure ...
+ * usage.report(result.metrics, "write_os_");
+ * }
+ *
+ * Metrics, each name prefixed: user_s, sys_s, vol_ctx_switches,
+ * invol_ctx_switches, major_faults, minor_faults, read_bytes and
+ * write_bytes (what reached the storage layer, from /proc/.../io), cycles
+ * and instructions (only if perf counters could be opened), and
+ * cpu_ns_per_mib / cpu_ns_per_op over what progress_add() saw meanwhile.
+ */
+class ResourceScope {
+public:
+    enum Scope { THREAD, PROCESS };
+
+    explicit ResourceScope(Scope scope = PROCESS): scope_(scope) {
+        cycles_fd_ = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+        instructions_fd_ = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+        ProgressCounters::instance().snapshot(progress_bytes_, progress_ops_);
+        io_ = read_io();
+        getrusage(scope_ == THREAD ? RUSAGE_THREAD : RUSAGE_SELF, &usage_);
+    }
+    ~ResourceScope() {
+        if (cycles_fd_ >= 0) close(cycles_fd_);
+        if (instructions_fd_ >= 0) close(instructions_fd_);
+    }
+    ResourceScope(const ResourceScope&) = delete;
+    ResourceScope& operator=(const ResourceScope&) = delete;
+
+    /** @brief Adds what was used since construction to `metrics`. */
+    void report(std::map<std::string, Metric>& metrics, const std::string& prefix = "os_") const {
+        struct rusage now;
+        getrusage(scope_ == THREAD ? RUSAGE_THREAD : RUSAGE_SELF, &now);
+        uint64_t user_ns = timeval_ns(now.ru_utime) - timeval_ns(usage_.ru_utime);
+        uint64_t sys_ns = timeval_ns(now.ru_stime) - timeval_ns(usage_.ru_stime);
+        metrics[prefix + "user_s"] = user_ns / 1.0e9;
+        metrics[prefix + "sys_s"] = sys_ns / 1.0e9;
+        metrics[prefix + "vol_ctx_switches"] = now.ru_nvcsw - usage_.ru_nvcsw;
+        metrics[prefix + "invol_ctx_switches"] = now.ru_nivcsw - usage_.ru_nivcsw;
+        metrics[prefix + "major_faults"] = now.ru_majflt - usage_.ru_majflt;
+        metrics[prefix + "minor_faults"] = now.ru_minflt - usage_.ru_minflt;
+
+        Io io = read_io();
+        if (io.ok && io_.ok) {
+            metrics[prefix + "read_bytes"] = io.read_bytes - io_.read_bytes;
+            metrics[prefix + "write_bytes"] = io.write_bytes - io_.write_bytes;
+        }
+        uint64_t value;
+        if (read_counter(cycles_fd_, value)) metrics[prefix + "cycles"] = value;
+        if (read_counter(instructions_fd_, value)) metrics[prefix + "instructions"] = value;
+
+        uint64_t bytes, ops;
+        ProgressCounters::instance().snapshot(bytes, ops);
+        // The sampler may have reset the counters since; then there is no delta to go by.
+        if (bytes > progress_bytes_) {
+            double mib = (bytes - progress_bytes_) / (1024.0 * 1024.0);
+            metrics[prefix + "cpu_ns_per_mib"] = Metric((user_ns + sys_ns) / mib).with_unit("ns/MiB");
+        }
+        if (ops > progress_ops_) {
+            metrics[prefix + "cpu_ns_per_op"] = Metric((user_ns + sys_ns) / double(ops - progress_ops_)).with_unit("ns");
+        }
+    }
+
+private:
+    struct Io {
+        uint64_t read_bytes = 0;
+        uint64_t write_bytes = 0;
+        bool ok = false;
+    };
+
+    static uint64_t timeval_ns(const struct timeval& tv) {
+        return tv.tv_sec * 1000000000ull + tv.tv_usec * 1000ull;
+    }
+
+    Io read_io() const {
+        Io io;
+        std::ifstream file(scope_ == THREAD ? "/proc/thread-self/io" : "/proc/self/io");
+        std::string key;
+        uint64_t value;
+        while (file >> key >> value) {
+            if (key == "read_bytes:") io.read_bytes = value;
+            else if (key == "write_bytes:") io.write_bytes = value;
+        }
+        io.ok = file.eof();
+        return io;
+    }
+
+    /** @return -1 if perf counters aren't available (no PMU, perf_event_paranoid, seccomp). */
+    int open_counter(uint64_t config) const {
+        struct perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1; // What unprivileged users may count
+        attr.exclude_hv = 1;
+        attr.inherit = scope_ == PROCESS; // Threads started from here on, added in as they exit
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    /** @brief Reads a counter, scaled up if it was multiplexed with others. */
+    static bool read_counter(int fd, uint64_t& value) {
+        uint64_t data[3]; // value, time enabled, time running
+        if (fd < 0 || read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) return false;
+        value = data[2] < data[1] ? static_cast<uint64_t>(data[0] * (double(data[1]) / data[2])) : data[0];
+        return true;
+    }
+
+    Scope scope_;
+    struct rusage usage_;
+    Io io_;
+    uint64_t progress_bytes_ = 0;
+    uint64_t progress_ops_ = 0;
+    int cycles_fd_ = -1;
+    int instructions_fd_ = -1;
+};
+
+
+
+/**
+ * @brief RAII recorder for a TimedRegion, like ScopedTimer but in absolute time.
+ * Usage:
+ * {
+ * RegionTimer t(result.regions["write"]);
+ * // ... code to time ...
+ * t.add_bytes(n);
+ * } // start_ns / end_ns / bytes are set on destruction
+ */
+class RegionTimer {
+public:
+    explicit RegionTimer(TimedRegion& region_out)
+        : region_out_(region_out), start_ns_(realtime_ns()) {}
+
+    ~RegionTimer() {
+        region_out_.start_ns = start_ns_;
+        region_out_.end_ns = realtime_ns();
+        region_out_.bytes = bytes_;
+    }
+
+    void add_bytes(uint64_t bytes) { bytes_ += bytes; }
+
+private:
+    TimedRegion& region_out_;
+    uint64_t start_ns_;
+    uint64_t bytes_ = 0;
+};
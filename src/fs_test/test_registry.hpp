@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base_test.hpp"
+
+/**
+ * @brief Name -> factory map used by the server and the worker agent to
+ * instantiate the same BaseTest from a test_name on the wire.
+ *
+ * Tests register themselves at static-initialization time with REGISTER_TEST,
+ * so their translation units must be linked in directly (see the fs_test
+ * OBJECT library).
+ */
+class TestRegistry {
+public:
+    /**
+     * @brief Builds a test. `config` carries the test-wide configuration on
+     * the server (worker_id = -1) and the worker's own context on a worker.
+     */
+    using Factory = std::function<std::unique_ptr<BaseTest>(const TestContext& config)>;
+
+    static TestRegistry& instance() {
+        static TestRegistry registry;
+        return registry;
+    }
+
+    bool add(const std::string& name, Factory factory) {
+        return factories_.emplace(name, std::move(factory)).second;
+    }
+
+    /** @return nullptr if no test is registered under `name`. */
+    std::unique_ptr<BaseTest> create(const std::string& name, const TestContext& config) const {
+        auto it = factories_.find(name);
+        return (it == factories_.end()) ? nullptr : it->second(config);
+    }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> out;
+        for (const auto& [name, factory] : factories_) out.push_back(name);
+        return out;
+    }
+
+private:
+    std::map<std::string, Factory> factories_;
+};
+
+#define TEST_REGISTRY_CONCAT_(a, b) a##b
+#define TEST_REGISTRY_CONCAT(a, b) TEST_REGISTRY_CONCAT_(a, b)
+
+/**
+ * @brief Registers a factory under a name.
+ * Usage: REGISTER_TEST("hardlink", [](const TestContext& config) {
+ *            return std::make_unique<HardlinkTest>(config.params.at("root"));
+ *        });
+ */
+#define REGISTER_TEST(name, factory) \
+    static const bool TEST_REGISTRY_CONCAT(test_registered_, __LINE__) = \
+        TestRegistry::instance().add(name, factory);
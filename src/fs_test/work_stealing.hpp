@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed pool of threads draining per-thread deques with work
+ * stealing, for tree-shaped jobs where running a task pushes more (a
+ * directory task queues its children).
+ *
+ * Each thread owns a deque: it pushes and pops at the back (LIFO, so a tree
+ * is walked depth-first and the backlog stays small), and a thread whose
+ * deque is empty steals from the front of another, where the oldest and
+ * usually biggest subtrees sit. A thread that finds nothing anywhere sleeps
+ * until a push or the end of the job instead of spinning.
+ *
+ *     WorkStealingPool<std::string> pool(num_threads);
+ *     bool ok = pool.run(root, [&](int self, std::string& dir) {
+ *         ...                      // pool.push(self, child) for every subdirectory
+ *         return true;             // false aborts the whole job
+ *     });
+ */
+template <typename Task>
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int num_threads): num_threads_(num_threads), queues_(num_threads) {}
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /** @brief Queues a task on thread `self`'s deque; call from inside a running task. */
+    void push(int self, Task task) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues_[self].mtx);
+            queues_[self].tasks.push_back(std::move(task));
+        }
+        pushes_.fetch_add(1);
+        // Pairs with wait_for_work(): either we see the sleeper, or it sees this push.
+        if (sleepers_.load() > 0) {
+            std::lock_guard<std::mutex> lock(idle_mtx_);
+            idle_cv_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Runs work(self, task) on every thread, starting from `root`,
+     * until no task is queued or running.
+     * @param work Called with the thread index (for push() and per-thread
+     * state) and the task; returns false to abort the job.
+     * @return false if any task failed; the tasks still queued then are dropped.
+     */
+    template <typename Work>
+    bool run(Task root, Work work) {
+        failed_ = false;
+        pending_ = 0;
+        push(0, std::move(root));
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads_; ++i) {
+            threads.emplace_back([this, i, &work] { drain(i, work); });
+        }
+        for (auto& t : threads) t.join();
+        for (WorkQueue& queue : queues_) queue.tasks.clear();
+        return !failed_;
+    }
+
+private:
+    struct alignas(64) WorkQueue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(int self, Task& task) {
+        {
+            WorkQueue& own = queues_[self];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < num_threads_; ++k) {
+            WorkQueue& victim = queues_[(self + k) % num_threads_];
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool finished() const {
+        return pending_.load(std::memory_order_acquire) == 0 || failed_.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Sleeps until a task is pushed after `seen` was read, or the job is over. */
+    void wait_for_work(uint64_t seen) {
+        std::unique_lock<std::mutex> lock(idle_mtx_);
+        sleepers_.fetch_add(1);
+        idle_cv_.wait(lock, [&] { return pushes_.load() != seen || finished(); });
+        sleepers_.fetch_sub(1);
+    }
+
+    /** @brief Ends the job for everyone: after the last task, or on failure. */
+    void wake_all() {
+        std::lock_guard<std::mutex> lock(idle_mtx_);
+        idle_cv_.notify_all();
+    }
+
+    template <typename Work>
+    void drain(int self, Work& work) {
+        Task task;
+        // pending_ counts queued and running tasks; a running task may still
+        // push more, so only 0 means the job is done.
+        while (!finished()) {
+            uint64_t seen = pushes_.load();
+            if (!pop(self, task)) {
+                wait_for_work(seen);
+                continue;
+            }
+            if (!work(self, task)) {
+                failed_ = true;
+                wake_all();
+            }
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) wake_all();
+        }
+    }
+
+    const int num_threads_;
+    std::vector<WorkQueue> queues_;
+    std::atomic<int64_t> pending_{0};
+    std::atomic<bool> failed_{false};
+
+    std::mutex idle_mtx_;
+    std::condition_variable idle_cv_;
+    std::atomic<uint64_t> pushes_{0};
+    std::atomic<int> sleepers_{0};
+};
@@ -0,0 +1,184 @@
+// Prints runs from a result store written by server.exe --results.
+//
+// Usage: result_dump STORE [--test NAME] [--last N] [--run ID]
+//                          [--metric KEY [--param KEY]]
+//
+//   (default)       One line per run: id, time, test, workers, pass/fail, params.
+//   --run ID        Everything recorded for one run, per worker.
+//   --metric KEY    Table of KEY (sum / mean / min / max over workers) per run;
+//                   with --param, the value of that param as the first column,
+//                   e.g. --metric bandwidth_gbps --param block_size.
+//                   Without --param, only runs with the same params as the
+//                   newest matching run are listed, so rows are comparable.
+//
+// Runs are picked from the index alone; only the chosen runs' blocks are read.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "result_store.hpp"
+
+using namespace result_store;
+
+namespace {
+
+struct Options {
+    std::string store;
+    std::string test;
+    size_t last = 0;
+    uint64_t run_id = 0;
+    std::string metric;
+    std::string param;
+};
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    if (argc < 2) return false;
+    opt.store = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (flag == "--test") opt.test = value;
+        else if (flag == "--last") opt.last = std::stoull(value);
+        else if (flag == "--run") opt.run_id = std::stoull(value);
+        else if (flag == "--metric") opt.metric = value;
+        else if (flag == "--param") opt.param = value;
+        else return false;
+    }
+    return opt.param.empty() || !opt.metric.empty();
+}
+
+std::string format_time(uint64_t timestamp_ns) {
+    std::time_t secs = static_cast<std::time_t>(timestamp_ns / 1000000000ull);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", std::localtime(&secs));
+    return buf;
+}
+
+void print_summary(const RunView& run) {
+    uint32_t passed = 0;
+    for (uint32_t w = 0; w < run.num_workers(); ++w) passed += run.success(w);
+    std::printf("%6llu  %s  %-24s %3u workers  %3u ok ",
+                static_cast<unsigned long long>(run.run_id()), format_time(run.timestamp_ns()).c_str(),
+                run.test_name().c_str(), run.num_workers(), passed);
+    for (const auto& [key, value] : run.params()) std::printf(" %s=%s", key.c_str(), value.c_str());
+    std::printf("\n");
+}
+
+void print_run(const RunView& run) {
+    print_summary(run);
+    for (uint32_t w = 0; w < run.num_workers(); ++w) {
+        std::printf("  worker %u: %s  %.3f s\n", w, run.success(w) ? "ok" : "FAILED",
+                    run.duration_ns(w) / 1e9);
+        if (!run.success(w)) std::printf("    error: %s\n", run.error(w).c_str());
+    }
+    std::vector<std::string> values;
+    for (const std::string& name : run.metric_names()) {
+        run.metric_strings(name, values);
+        std::printf("  metric %s:", name.c_str());
+        for (const std::string& v : values) std::printf(" %s", v.empty() ? "-" : v.c_str());
+        std::printf("\n");
+    }
+    LatencyHistogram hist;
+    for (const std::string& name : run.histogram_names()) {
+        for (uint32_t w = 0; w < run.num_workers(); ++w) {
+            if (!run.histogram(name, w, hist) || hist.count() == 0) continue;
+            std::printf("  latency %s [worker %u]: n=%llu mean=%.0f p50=%llu p99=%llu max=%llu ns\n",
+                        name.c_str(), w, static_cast<unsigned long long>(hist.count()), hist.mean(),
+                        static_cast<unsigned long long>(hist.percentile(50)),
+                        static_cast<unsigned long long>(hist.percentile(99)),
+                        static_cast<unsigned long long>(hist.max()));
+        }
+    }
+    TimedRegion region;
+    for (const std::string& name : run.region_names()) {
+        for (uint32_t w = 0; w < run.num_workers(); ++w) {
+            if (!run.region(name, w, region)) continue;
+            std::printf("  region %s [worker %u]: start=%llu %.3f s %llu bytes\n", name.c_str(), w,
+                        static_cast<unsigned long long>(region.start_ns),
+                        (region.end_ns - region.start_ns) / 1e9,
+                        static_cast<unsigned long long>(region.bytes));
+        }
+    }
+    for (uint32_t w = 0; w < run.num_workers(); ++w) {
+        std::vector<ProgressSample> samples = run.timeline(w);
+        if (samples.empty()) continue;
+        std::printf("  timeline [worker %u]: %zu samples, %llu bytes, %llu ops\n", w, samples.size(),
+                    static_cast<unsigned long long>(samples.back().bytes),
+                    static_cast<unsigned long long>(samples.back().ops));
+    }
+}
+
+/** @brief One row per run: [param] sum mean min max of the metric over workers that reported it. */
+void print_metric_table(const Reader& reader, const std::vector<size_t>& runs, const Options& opt) {
+    std::printf("%6s  %-24s", "run", "test");
+    if (!opt.param.empty()) std::printf(" %16s", opt.param.c_str());
+    std::printf(" %14s %14s %14s %14s\n", "sum", "mean", "min", "max");
+
+    std::vector<double> column;
+    for (size_t i : runs) {
+        RunView run;
+        if (!reader.run(i, run) || !run.metric(opt.metric, column)) continue;
+        double sum = 0, lo = std::numeric_limits<double>::infinity(), hi = -lo;
+        size_t n = 0;
+        for (double v : column) {
+            if (std::isnan(v)) continue;
+            sum += v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+            n++;
+        }
+        if (n == 0) continue;
+        std::printf("%6llu  %-24s", static_cast<unsigned long long>(run.run_id()), run.test_name().c_str());
+        if (!opt.param.empty()) std::printf(" %16s", run.param(opt.param, "-").c_str());
+        std::printf(" %14.6g %14.6g %14.6g %14.6g\n", sum, sum / n, lo, hi);
+    }
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "Usage: %s STORE [--test NAME] [--last N] [--run ID] [--metric KEY [--param KEY]]\n",
+                     argv[0]);
+        return 1;
+    }
+    Reader reader;
+    if (!reader.open(opt.store)) {
+        std::fprintf(stderr, "Cannot open result store %s\n", opt.store.c_str());
+        return 1;
+    }
+
+    std::vector<size_t> runs = reader.find(opt.test, opt.last);
+    if (opt.run_id) {
+        auto it = std::find_if(runs.begin(), runs.end(),
+                               [&](size_t i) { return reader.entry(i).run_id == opt.run_id; });
+        RunView run;
+        if (it == runs.end() || !reader.run(*it, run)) {
+            std::fprintf(stderr, "No run %llu\n", static_cast<unsigned long long>(opt.run_id));
+            return 1;
+        }
+        print_run(run);
+        return 0;
+    }
+    if (!opt.metric.empty()) {
+        if (opt.param.empty() && !runs.empty()) {
+            runs = reader.find(opt.test, opt.last, reader.entry(runs.back()).params_hash);
+        }
+        print_metric_table(reader, runs, opt);
+        return 0;
+    }
+    for (size_t i : runs) {
+        RunView run;
+        if (reader.run(i, run)) print_summary(run);
+        else std::fprintf(stderr, "run %llu: corrupt block\n", static_cast<unsigned long long>(reader.entry(i).run_id));
+    }
+    return 0;
+}
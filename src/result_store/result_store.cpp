@@ -0,0 +1,624 @@
+#include "result_store.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace result_store {
+
+namespace {
+
+uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/** @brief Payload builder; everything is appended in host (little-endian) order. */
+struct Bytes {
+    std::string buf;
+
+    template <typename T>
+    void put(T value) { buf.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    void put_string(const std::string& s) {
+        put<uint32_t>(static_cast<uint32_t>(s.size()));
+        buf.append(s);
+    }
+
+    void put_strings(const std::vector<std::string>& strings) {
+        put<uint32_t>(static_cast<uint32_t>(strings.size()));
+        for (const std::string& s : strings) put_string(s);
+    }
+};
+
+struct PendingSection {
+    SectionKind kind;
+    std::string name;
+    std::string data;
+};
+
+template <typename T>
+T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Rebuilds the index entry of a block read back from the data file.
+ * @return false if the block's directory or name/params sections are malformed.
+ */
+bool index_block(const std::string& block, uint64_t block_offset, IndexEntry& out) {
+    BlockHeader header = load<BlockHeader>(block.data());
+    uint64_t dir_end = sizeof(BlockHeader) + uint64_t(header.num_sections) * sizeof(SectionEntry);
+    if (dir_end > block.size()) return false;
+    std::string test_name;
+    std::map<std::string, std::string> params;
+    bool named = false, has_params = false;
+    for (uint32_t s = 0; s < header.num_sections; ++s) {
+        SectionEntry section = load<SectionEntry>(block.data() + sizeof(BlockHeader) + s * sizeof(SectionEntry));
+        if (section.data_offset > block.size() || section.data_len > block.size() - section.data_offset) return false;
+        const char* p = block.data() + section.data_offset;
+        if (section.kind == static_cast<uint32_t>(SectionKind::TEST_NAME)) {
+            test_name.assign(p, section.data_len);
+            named = true;
+        } else if (section.kind == static_cast<uint32_t>(SectionKind::PARAMS)) {
+            // key, value, key, value, ... as a string list
+            if (section.data_len < 4) return false;
+            uint32_t count = load<uint32_t>(p);
+            uint64_t pos = 4;
+            std::string key;
+            for (uint32_t i = 0; i < count; ++i) {
+                if (pos + 4 > section.data_len) return false;
+                uint32_t len = load<uint32_t>(p + pos);
+                pos += 4;
+                if (len > section.data_len - pos) return false;
+                std::string item(p + pos, len);
+                pos += len;
+                if (i % 2 == 0) key = std::move(item);
+                else params[key] = std::move(item);
+            }
+            has_params = true;
+        }
+    }
+    if (!named || !has_params) return false;
+
+    out = IndexEntry{};
+    out.run_id = header.run_id;
+    out.timestamp_ns = header.timestamp_ns;
+    out.block_offset = block_offset;
+    out.block_len = header.block_len;
+    out.test_name_hash = hash_string(test_name);
+    out.params_hash = hash_params(params);
+    std::memcpy(out.test_name, test_name.data(), std::min(test_name.size(), sizeof(out.test_name)));
+    return true;
+}
+
+} // namespace
+
+
+uint64_t hash_string(const std::string& s) {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    for (unsigned char c : s) h = (h ^ c) * 0x100000001b3ull;
+    return h;
+}
+
+uint64_t hash_params(const std::map<std::string, std::string>& params) {
+    // std::map iterates in key order, so equal maps always hash equal.
+    std::string flat;
+    for (const auto& [key, value] : params) {
+        flat.append(key).push_back('\0');
+        flat.append(value).push_back('\0');
+    }
+    return hash_string(flat);
+}
+
+
+// --- Writer ---
+
+Writer::~Writer() { close(); }
+
+bool Writer::open(const std::string& path) {
+    close();
+    data_fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    index_fd_ = ::open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+    if (data_fd_ < 0 || index_fd_ < 0) {
+        close();
+        return false;
+    }
+
+    // Drop whatever a crashed append left behind: a partial index entry,
+    // entries whose block never fully reached the data file, and a torn
+    // block after the last whole one.
+    struct stat index_st, data_st;
+    if (fstat(index_fd_, &index_st) != 0 || fstat(data_fd_, &data_st) != 0) {
+        close();
+        return false;
+    }
+    uint64_t entries = static_cast<uint64_t>(index_st.st_size) / sizeof(IndexEntry);
+    uint64_t data_end = 0;
+    while (entries > 0) {
+        IndexEntry last;
+        if (pread(index_fd_, &last, sizeof(last), (entries - 1) * sizeof(IndexEntry)) != sizeof(last)) {
+            close();
+            return false;
+        }
+        next_run_id_ = std::max(next_run_id_, last.run_id + 1); // Never reuse an id
+        if (last.block_offset + last.block_len <= static_cast<uint64_t>(data_st.st_size)) {
+            data_end = last.block_offset + last.block_len;
+            break;
+        }
+        entries--;
+    }
+    // Whole blocks past the last indexed one are runs whose index entry
+    // never got written, or whose index was lost (e.g. the .idx deleted):
+    // index them again rather than truncate them away.
+    std::string block;
+    IndexEntry recovered;
+    while (data_end + sizeof(BlockHeader) <= static_cast<uint64_t>(data_st.st_size)) {
+        BlockHeader header;
+        if (pread(data_fd_, &header, sizeof(header), data_end) != sizeof(header) ||
+            header.magic != BLOCK_MAGIC || header.version != FORMAT_VERSION ||
+            header.block_len < sizeof(BlockHeader) || header.block_len % 8 != 0 ||
+            header.block_len > static_cast<uint64_t>(data_st.st_size) - data_end) {
+            break;
+        }
+        block.resize(header.block_len);
+        if (pread(data_fd_, &block[0], block.size(), data_end) != static_cast<ssize_t>(block.size()) ||
+            !index_block(block, data_end, recovered)) {
+            break;
+        }
+        if (pwrite(index_fd_, &recovered, sizeof(recovered), entries * sizeof(IndexEntry)) != sizeof(recovered)) {
+            close();
+            return false;
+        }
+        entries++;
+        next_run_id_ = std::max(next_run_id_, header.run_id + 1);
+        data_end += header.block_len;
+    }
+    if (ftruncate(index_fd_, entries * sizeof(IndexEntry)) != 0 || ftruncate(data_fd_, data_end) != 0) {
+        close();
+        return false;
+    }
+    lseek(index_fd_, 0, SEEK_END);
+    lseek(data_fd_, 0, SEEK_END);
+    return true;
+}
+
+void Writer::close() {
+    if (data_fd_ >= 0) ::close(data_fd_);
+    if (index_fd_ >= 0) ::close(index_fd_);
+    data_fd_ = index_fd_ = -1;
+}
+
+uint64_t Writer::append(const RunRecord& record) {
+    if (data_fd_ < 0) return 0;
+    const size_t workers = record.results.size();
+    std::vector<PendingSection> sections;
+
+    sections.push_back({SectionKind::TEST_NAME, "", record.test_name});
+
+    Bytes params;
+    std::vector<std::string> flat;
+    for (const auto& [key, value] : record.params) {
+        flat.push_back(key);
+        flat.push_back(value);
+    }
+    params.put_strings(flat);
+    sections.push_back({SectionKind::PARAMS, "", std::move(params.buf)});
+
+    Bytes status, errors;
+    std::vector<std::string> error_msgs;
+    for (const TestResult& r : record.results) status.put<uint64_t>(r.duration_ns);
+    for (const TestResult& r : record.results) status.put<uint64_t>(r.success ? 1 : 0);
+    for (const TestResult& r : record.results) error_msgs.push_back(r.error_msg);
+    errors.put_strings(error_msgs);
+    sections.push_back({SectionKind::STATUS, "", std::move(status.buf)});
+    sections.push_back({SectionKind::ERRORS, "", std::move(errors.buf)});
+
+    // One column per name, across all workers. Names are gathered first so a
+    // worker missing a key still gets its slot.
+    std::set<std::string> metric_names, histogram_names, region_names;
+    for (const TestResult& r : record.results) {
+        for (const auto& kv : r.metrics) metric_names.insert(kv.first);
+        for (const auto& kv : r.histograms) histogram_names.insert(kv.first);
+        for (const auto& kv : r.regions) region_names.insert(kv.first);
+    }
+
+    for (const std::string& name : metric_names) {
+        std::vector<double> numbers(workers, std::nan(""));
+        std::vector<std::string> strings(workers);
+        bool numeric = true;
+        for (size_t w = 0; w < workers; ++w) {
+            auto it = record.results[w].metrics.find(name);
+            if (it == record.results[w].metrics.end()) continue;
+            // Text and arrays make the column text; numbers need no parsing.
+            strings[w] = it->second.to_string();
+            numeric = numeric && it->second.is_number();
+            if (it->second.is_number()) numbers[w] = it->second.as_double();
+        }
+        Bytes column;
+        if (numeric) {
+            for (double v : numbers) column.put<double>(v);
+            sections.push_back({SectionKind::METRIC_F64, name, std::move(column.buf)});
+        } else {
+            column.put_strings(strings);
+            sections.push_back({SectionKind::METRIC_STR, name, std::move(column.buf)});
+        }
+    }
+
+    for (const std::string& name : histogram_names) {
+        Bytes column;
+        for (const TestResult& r : record.results) {
+            auto it = r.histograms.find(name);
+            if (it == r.histograms.end()) {
+                for (int i = 0; i < 5; ++i) column.put<uint64_t>(0);
+                continue;
+            }
+            const LatencyHistogram& hist = it->second;
+            std::vector<int64_t> counts = hist.encode_counts();
+            column.put<uint64_t>(hist.count());
+            column.put<uint64_t>(hist.sum());
+            column.put<uint64_t>(hist.min());
+            column.put<uint64_t>(hist.max());
+            column.put<uint64_t>(counts.size());
+            for (int64_t c : counts) column.put<int64_t>(c);
+        }
+        sections.push_back({SectionKind::HISTOGRAM, name, std::move(column.buf)});
+    }
+
+    for (const std::string& name : region_names) {
+        Bytes column;
+        for (const TestResult& r : record.results) {
+            auto it = r.regions.find(name);
+            TimedRegion region = it == r.regions.end() ? TimedRegion{} : it->second;
+            column.put<uint64_t>(region.start_ns);
+            column.put<uint64_t>(region.end_ns);
+            column.put<uint64_t>(region.bytes);
+        }
+        sections.push_back({SectionKind::REGION, name, std::move(column.buf)});
+    }
+
+    bool any_timeline = false;
+    for (const TestResult& r : record.results) any_timeline = any_timeline || !r.timeline.empty();
+    if (any_timeline) {
+        Bytes column;
+        for (const TestResult& r : record.results) {
+            column.put<uint64_t>(r.timeline.size());
+            for (const ProgressSample& s : r.timeline) {
+                column.put<uint64_t>(s.t_ns);
+                column.put<uint64_t>(s.bytes);
+                column.put<uint64_t>(s.ops);
+            }
+        }
+        sections.push_back({SectionKind::TIMELINE, "", std::move(column.buf)});
+    }
+
+    // Layout: header | section directory | names | payloads (each 8-aligned)
+    std::vector<SectionEntry> directory(sections.size());
+    uint64_t offset = sizeof(BlockHeader) + sections.size() * sizeof(SectionEntry);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        directory[i].kind = static_cast<uint32_t>(sections[i].kind);
+        directory[i].name_len = static_cast<uint32_t>(sections[i].name.size());
+        directory[i].name_offset = offset;
+        offset += sections[i].name.size();
+    }
+    for (size_t i = 0; i < sections.size(); ++i) {
+        offset = align8(offset);
+        directory[i].data_offset = offset;
+        directory[i].data_len = sections[i].data.size();
+        offset += sections[i].data.size();
+    }
+    const uint64_t block_len = align8(offset);
+
+    BlockHeader header{};
+    header.magic = BLOCK_MAGIC;
+    header.version = FORMAT_VERSION;
+    header.block_len = block_len;
+    header.run_id = next_run_id_;
+    header.timestamp_ns = record.timestamp_ns ? record.timestamp_ns :
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    header.num_workers = static_cast<uint32_t>(workers);
+    header.num_sections = static_cast<uint32_t>(sections.size());
+
+    std::string block(block_len, '\0');
+    std::memcpy(&block[0], &header, sizeof(header));
+    std::memcpy(&block[sizeof(header)], directory.data(), directory.size() * sizeof(SectionEntry));
+    for (size_t i = 0; i < sections.size(); ++i) {
+        std::memcpy(&block[directory[i].name_offset], sections[i].name.data(), sections[i].name.size());
+        std::memcpy(&block[directory[i].data_offset], sections[i].data.data(), sections[i].data.size());
+    }
+
+    off_t block_offset = lseek(data_fd_, 0, SEEK_END);
+    if (block_offset < 0 || !write_all(data_fd_, block.data(), block.size())) return 0;
+    // The block must be durable before the index points at it.
+    if (fdatasync(data_fd_) != 0) return 0;
+
+    IndexEntry entry{};
+    entry.run_id = header.run_id;
+    entry.timestamp_ns = header.timestamp_ns;
+    entry.block_offset = static_cast<uint64_t>(block_offset);
+    entry.block_len = block_len;
+    entry.test_name_hash = hash_string(record.test_name);
+    entry.params_hash = hash_params(record.params);
+    std::memcpy(entry.test_name, record.test_name.data(),
+                std::min(record.test_name.size(), sizeof(entry.test_name)));
+    if (!write_all(index_fd_, reinterpret_cast<const char*>(&entry), sizeof(entry))) return 0;
+
+    return next_run_id_++;
+}
+
+
+// --- Reader ---
+
+Reader::~Reader() { close(); }
+
+bool Reader::open(const std::string& path) {
+    close();
+    int data_fd = ::open(path.c_str(), O_RDONLY);
+    if (data_fd < 0) return false;
+    struct stat st;
+    if (fstat(data_fd, &st) != 0) {
+        ::close(data_fd);
+        return false;
+    }
+    data_len_ = static_cast<size_t>(st.st_size);
+    if (data_len_ > 0) {
+        void* map = mmap(nullptr, data_len_, PROT_READ, MAP_SHARED, data_fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(data_fd);
+            data_len_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(map);
+    }
+    ::close(data_fd);
+
+    int index_fd = ::open((path + ".idx").c_str(), O_RDONLY);
+    if (index_fd < 0) return true; // No runs yet
+    IndexEntry entry;
+    while (::read(index_fd, &entry, sizeof(entry)) == sizeof(entry)) {
+        // A writer still appending (or one that crashed) can leave entries
+        // beyond what we mapped; they just aren't visible yet.
+        if (entry.block_offset % 8 == 0 && entry.block_len >= sizeof(BlockHeader) &&
+            entry.block_offset + entry.block_len <= data_len_) {
+            entries_.push_back(entry);
+        }
+    }
+    ::close(index_fd);
+    return true;
+}
+
+void Reader::close() {
+    if (data_) munmap(const_cast<char*>(data_), data_len_);
+    data_ = nullptr;
+    data_len_ = 0;
+    entries_.clear();
+}
+
+bool Reader::run(size_t i, RunView& out) const {
+    if (i >= entries_.size()) return false;
+    const IndexEntry& entry = entries_[i];
+    const char* block = data_ + entry.block_offset;
+    auto header = reinterpret_cast<const BlockHeader*>(block);
+    if (header->magic != BLOCK_MAGIC || header->version != FORMAT_VERSION ||
+        header->block_len != entry.block_len || header->run_id != entry.run_id) {
+        return false;
+    }
+    uint64_t dir_end = sizeof(BlockHeader) + uint64_t(header->num_sections) * sizeof(SectionEntry);
+    if (dir_end > header->block_len) return false;
+    auto directory = reinterpret_cast<const SectionEntry*>(block + sizeof(BlockHeader));
+    for (uint32_t s = 0; s < header->num_sections; ++s) {
+        const SectionEntry& section = directory[s];
+        if (section.name_offset + section.name_len > header->block_len ||
+            section.data_offset + section.data_len > header->block_len ||
+            section.data_offset % 8 != 0) {
+            return false;
+        }
+    }
+    out = RunView(block, header);
+    return true;
+}
+
+std::vector<size_t> Reader::find(const std::string& test_name, size_t last_n, uint64_t params_hash) const {
+    std::vector<size_t> matches;
+    const uint64_t hash = hash_string(test_name);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (params_hash && entries_[i].params_hash != params_hash) continue;
+        if (test_name.empty() ||
+            (entries_[i].test_name_hash == hash &&
+             std::strncmp(entries_[i].test_name, test_name.c_str(), sizeof(IndexEntry::test_name)) == 0)) {
+            matches.push_back(i);
+        }
+    }
+    if (last_n && matches.size() > last_n) matches.erase(matches.begin(), matches.end() - last_n);
+    return matches;
+}
+
+
+// --- RunView ---
+
+const SectionEntry* RunView::find(SectionKind kind, const std::string& name) const {
+    auto directory = reinterpret_cast<const SectionEntry*>(block_ + sizeof(BlockHeader));
+    for (uint32_t s = 0; s < header_->num_sections; ++s) {
+        if (directory[s].kind == static_cast<uint32_t>(kind) && name_of(directory[s]) == name) {
+            return &directory[s];
+        }
+    }
+    return nullptr;
+}
+
+std::string RunView::name_of(const SectionEntry& section) const {
+    return std::string(block_ + section.name_offset, section.name_len);
+}
+
+std::vector<std::string> RunView::names_of(SectionKind kind) const {
+    std::vector<std::string> names;
+    auto directory = reinterpret_cast<const SectionEntry*>(block_ + sizeof(BlockHeader));
+    for (uint32_t s = 0; s < header_->num_sections; ++s) {
+        if (directory[s].kind == static_cast<uint32_t>(kind)) names.push_back(name_of(directory[s]));
+    }
+    return names;
+}
+
+std::vector<std::string> RunView::strings(const SectionEntry* section) const {
+    std::vector<std::string> out;
+    if (!section || section->data_len < 4) return out;
+    const char* p = block_ + section->data_offset;
+    const char* end = p + section->data_len;
+    uint32_t count = load<uint32_t>(p);
+    p += 4;
+    for (uint32_t i = 0; i < count && p + 4 <= end; ++i) {
+        uint32_t len = load<uint32_t>(p);
+        p += 4;
+        if (p + len > end) break;
+        out.emplace_back(p, len);
+        p += len;
+    }
+    return out;
+}
+
+std::string RunView::test_name() const {
+    const SectionEntry* section = find(SectionKind::TEST_NAME);
+    return section ? std::string(block_ + section->data_offset, section->data_len) : "";
+}
+
+std::map<std::string, std::string> RunView::params() const {
+    std::vector<std::string> flat = strings(find(SectionKind::PARAMS));
+    std::map<std::string, std::string> params;
+    for (size_t i = 0; i + 1 < flat.size(); i += 2) params[flat[i]] = flat[i + 1];
+    return params;
+}
+
+std::string RunView::param(const std::string& key, const std::string& fallback) const {
+    auto all = params();
+    auto it = all.find(key);
+    return it == all.end() ? fallback : it->second;
+}
+
+bool RunView::success(uint32_t worker) const {
+    const SectionEntry* section = find(SectionKind::STATUS);
+    if (!section || worker >= num_workers() || section->data_len < 16ull * num_workers()) return false;
+    return load<uint64_t>(block_ + section->data_offset + 8ull * (num_workers() + worker)) != 0;
+}
+
+uint64_t RunView::duration_ns(uint32_t worker) const {
+    const SectionEntry* section = find(SectionKind::STATUS);
+    if (!section || worker >= num_workers() || section->data_len < 16ull * num_workers()) return 0;
+    return load<uint64_t>(block_ + section->data_offset + 8ull * worker);
+}
+
+std::string RunView::error(uint32_t worker) const {
+    std::vector<std::string> errors = strings(find(SectionKind::ERRORS));
+    return worker < errors.size() ? errors[worker] : "";
+}
+
+std::vector<std::string> RunView::metric_names() const {
+    std::vector<std::string> names = names_of(SectionKind::METRIC_F64);
+    std::vector<std::string> text = names_of(SectionKind::METRIC_STR);
+    names.insert(names.end(), text.begin(), text.end());
+    return names;
+}
+
+std::vector<std::string> RunView::histogram_names() const { return names_of(SectionKind::HISTOGRAM); }
+
+std::vector<std::string> RunView::region_names() const { return names_of(SectionKind::REGION); }
+
+bool RunView::metric(const std::string& name, std::vector<double>& out) const {
+    const SectionEntry* section = find(SectionKind::METRIC_F64, name);
+    if (!section || section->data_len < 8ull * num_workers()) return false;
+    auto column = reinterpret_cast<const double*>(block_ + section->data_offset);
+    out.assign(column, column + num_workers());
+    return true;
+}
+
+bool RunView::metric_strings(const std::string& name, std::vector<std::string>& out) const {
+    if (const SectionEntry* section = find(SectionKind::METRIC_STR, name)) {
+        out = strings(section);
+        out.resize(num_workers());
+        return true;
+    }
+    std::vector<double> numbers;
+    if (!metric(name, numbers)) return false;
+    out.clear();
+    for (double v : numbers) {
+        if (std::isnan(v)) {
+            out.emplace_back();
+            continue;
+        }
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.15g", v);
+        out.emplace_back(buf);
+    }
+    return true;
+}
+
+bool RunView::histogram(const std::string& name, uint32_t worker, LatencyHistogram& out) const {
+    const SectionEntry* section = find(SectionKind::HISTOGRAM, name);
+    if (!section || worker >= num_workers()) return false;
+    const char* p = block_ + section->data_offset;
+    const char* end = p + section->data_len;
+    // Entries are variable-length, so skip the workers before this one.
+    for (uint32_t w = 0;; ++w) {
+        if (p + 40 > end) return false;
+        uint64_t n = load<uint64_t>(p + 32);
+        if (p + 40 + 8 * n > end) return false;
+        if (w == worker) {
+            auto counts = reinterpret_cast<const int64_t*>(p + 40);
+            return out.decode_counts(counts, counts + n, load<uint64_t>(p), load<uint64_t>(p + 8),
+                                     load<uint64_t>(p + 16), load<uint64_t>(p + 24));
+        }
+        p += 40 + 8 * n;
+    }
+}
+
+bool RunView::region(const std::string& name, uint32_t worker, TimedRegion& out) const {
+    const SectionEntry* section = find(SectionKind::REGION, name);
+    if (!section || worker >= num_workers() || section->data_len < 24ull * num_workers()) return false;
+    const char* p = block_ + section->data_offset + 24ull * worker;
+    out.start_ns = load<uint64_t>(p);
+    out.end_ns = load<uint64_t>(p + 8);
+    out.bytes = load<uint64_t>(p + 16);
+    return out.end_ns != 0;
+}
+
+std::vector<ProgressSample> RunView::timeline(uint32_t worker) const {
+    std::vector<ProgressSample> samples;
+    const SectionEntry* section = find(SectionKind::TIMELINE);
+    if (!section || worker >= num_workers()) return samples;
+    const char* p = block_ + section->data_offset;
+    const char* end = p + section->data_len;
+    for (uint32_t w = 0; w <= worker; ++w) {
+        if (p + 8 > end) return samples;
+        uint64_t n = load<uint64_t>(p);
+        p += 8;
+        if (p + 24 * n > end) return samples;
+        if (w == worker) {
+            samples.resize(n);
+            for (uint64_t i = 0; i < n; ++i, p += 24) {
+                samples[i] = {load<uint64_t>(p), load<uint64_t>(p + 8), load<uint64_t>(p + 16)};
+            }
+            break;
+        }
+        p += 24 * n;
+    }
+    return samples;
+}
+
+} // namespace result_store
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../fs_test/base_test_types.hpp"
+
+/*
+ * Append-only, memory-mappable store of benchmark runs.
+ *
+ * Two files:
+ *   <path>      Blocks, one per run. A block is a header, a directory of
+ *               sections, and the sections' payloads. Every section is one
+ *               column over the run's workers (one metric, one histogram, one
+ *               region, ...), so a reader can jump straight to the column it
+ *               wants without touching the others.
+ *   <path>.idx  Fixed-size IndexEntry records, one per block: run id, time,
+ *               test name, a hash of the params and where the block is.
+ *               Scanning it to pick runs never touches the data file.
+ *
+ * A string list is a uint32 count followed by (uint32 length, bytes) pairs.
+ * All integers are little-endian and every payload starts 8-byte aligned,
+ * so the reader reads columns in place from the mapping.
+ */
+
+namespace result_store {
+
+constexpr uint32_t BLOCK_MAGIC = 0x42535248; // "HRSB"
+constexpr uint32_t FORMAT_VERSION = 1;
+
+enum class SectionKind : uint32_t {
+    TEST_NAME = 1,    // chars
+    PARAMS = 2,       // string list: key, value, key, value, ...
+    STATUS = 3,       // n x uint64 duration_ns, then n x uint64 success
+    ERRORS = 4,       // string list, one per worker
+    METRIC_F64 = 5,   // per worker: double (NaN = missing)
+    METRIC_STR = 6,   // string list, one per worker ("" = missing)
+    HISTOGRAM = 7,    // per worker: count, sum, min, max, n, n x int64 RLE counts
+    REGION = 8,       // per worker: start_ns, end_ns, bytes
+    TIMELINE = 9,     // per worker: n, then n x (t_ns, bytes, ops)
+};
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t block_len;
+    uint64_t run_id;
+    uint64_t timestamp_ns;
+    uint32_t num_workers;
+    uint32_t num_sections;
+};
+
+struct SectionEntry {
+    uint32_t kind;
+    uint32_t name_len;
+    uint64_t name_offset; // From the block start
+    uint64_t data_offset; // From the block start, 8-byte aligned
+    uint64_t data_len;
+};
+
+struct IndexEntry {
+    uint64_t run_id;
+    uint64_t timestamp_ns;
+    uint64_t block_offset;
+    uint64_t block_len;
+    uint64_t test_name_hash;
+    uint64_t params_hash;
+    char test_name[16]; // Truncated, NUL-padded; for display only
+};
+static_assert(sizeof(IndexEntry) == 64, "IndexEntry is an on-disk format");
+
+uint64_t hash_string(const std::string& s);
+/** @brief Order-independent hash of a params map (same map -> same hash). */
+uint64_t hash_params(const std::map<std::string, std::string>& params);
+
+
+/** @brief Everything recorded about one run of one test. */
+struct RunRecord {
+    std::string test_name;
+    uint64_t timestamp_ns = 0; // 0 = now
+    std::map<std::string, std::string> params;
+    std::vector<TestResult> results; // One per worker
+};
+
+
+class Writer {
+public:
+    Writer() = default;
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /**
+     * @brief Opens (creating if needed) a store for appending. Whole blocks
+     * the index does not cover are indexed again; only a torn last block is
+     * dropped.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * @brief Appends one run: its block first, then its index entry, so a
+     * crash between the two leaves an orphan block rather than a dangling
+     * index entry.
+     * @return The new run id, or 0 on failure.
+     */
+    uint64_t append(const RunRecord& record);
+
+private:
+    int data_fd_ = -1;
+    int index_fd_ = -1;
+    uint64_t next_run_id_ = 1;
+};
+
+
+class Reader;
+
+/** @brief Read-only view of one run's block, valid while its Reader is open. */
+class RunView {
+public:
+    RunView() = default;
+
+    uint64_t run_id() const { return header_->run_id; }
+    uint64_t timestamp_ns() const { return header_->timestamp_ns; }
+    uint32_t num_workers() const { return header_->num_workers; }
+    std::string test_name() const;
+    std::map<std::string, std::string> params() const;
+    /** @return fallback if the run has no such param. */
+    std::string param(const std::string& key, const std::string& fallback = "") const;
+
+    bool success(uint32_t worker) const;
+    uint64_t duration_ns(uint32_t worker) const;
+    std::string error(uint32_t worker) const;
+
+    /** @brief Names of every metric column (numeric and string). */
+    std::vector<std::string> metric_names() const;
+    std::vector<std::string> histogram_names() const;
+    std::vector<std::string> region_names() const;
+
+    /**
+     * @brief Reads a numeric metric column; missing values are NaN.
+     * @return false if the run has no numeric column of that name.
+     */
+    bool metric(const std::string& name, std::vector<double>& out) const;
+    /** @brief Reads any metric column as strings ("" = missing). */
+    bool metric_strings(const std::string& name, std::vector<std::string>& out) const;
+
+    bool histogram(const std::string& name, uint32_t worker, LatencyHistogram& out) const;
+    /** @return false if the worker did not record that region. */
+    bool region(const std::string& name, uint32_t worker, TimedRegion& out) const;
+    std::vector<ProgressSample> timeline(uint32_t worker) const;
+
+private:
+    friend class Reader;
+    RunView(const char* block, const BlockHeader* header): block_(block), header_(header) {}
+
+    const SectionEntry* find(SectionKind kind, const std::string& name = "") const;
+    std::vector<std::string> names_of(SectionKind kind) const;
+    std::vector<std::string> strings(const SectionEntry* section) const;
+    std::string name_of(const SectionEntry& section) const;
+
+    const char* block_ = nullptr;
+    const BlockHeader* header_ = nullptr;
+};
+
+
+class Reader {
+public:
+    Reader() = default;
+    ~Reader();
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /** @brief Maps the store read-only. Entries pointing past the data (a torn append) are ignored. */
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return entries_.size(); }
+    const IndexEntry& entry(size_t i) const { return entries_[i]; }
+
+    /** @return A view of run i, or false if its block fails validation. */
+    bool run(size_t i, RunView& out) const;
+
+    /**
+     * @brief Indexes of matching runs, oldest first, found from the index alone.
+     * @param test_name Empty = any test.
+     * @param last_n    Keep only the newest last_n matches (0 = all).
+     * @param params_hash Only runs whose hash_params() is this (0 = any params).
+     */
+    std::vector<size_t> find(const std::string& test_name, size_t last_n = 0, uint64_t params_hash = 0) const;
+
+private:
+    const char* data_ = nullptr;
+    size_t data_len_ = 0;
+    std::vector<IndexEntry> entries_;
+};
+
+} // namespace result_store
@@ -0,0 +1,366 @@
+#include "../fs_test/grpc_client_manager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <limits>
+
+#include "server_communicator.hpp"
+#include "../comm_utils/clock.hpp"
+#include "../fs_test/proto_convert.hpp"
+
+namespace {
+
+/**
+ * @brief Pops results from one worker until the one with request_id arrives.
+ *
+ * Each worker runs its requests in order, so anything popped before the
+ * match is a leftover from an earlier, abandoned call.
+ * @return false if the worker disconnected or deadline_ns passed first.
+ */
+bool await_result(ServerCommunicator& comm, size_t slot, uint64_t request_id, uint64_t deadline_ns,
+                  hpcfs_bench::TestResult& result) {
+    for (;;) {
+        if (comm.receive_any({slot}, result, deadline_ns) == ServerCommunicator::NO_WORKER) return false;
+        if (result.request_id() == request_id) return true;
+        std::cout << "Worker slot " << slot << ": dropping stale result " << result.request_id() << std::endl;
+    }
+}
+
+/** @brief Two-sided 95% Student t critical value for `df` degrees of freedom. */
+double t_critical_95(size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (df == 0) return std::numeric_limits<double>::infinity();
+    return df <= 30 ? table[df - 1] : 1.960;
+}
+
+/**
+ * @brief One iteration's primary metric (see IterationPolicy).
+ * @return NaN if no worker reported it.
+ */
+double primary_metric(const std::vector<TestResult>& results, const std::string& metric) {
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    if (metric.empty()) {
+        uint64_t slowest = 0;
+        for (const TestResult& r : results) slowest = std::max(slowest, r.duration_ns);
+        return slowest / 1.0e9;
+    }
+    if (metric.compare(0, 7, "region:") == 0) {
+        std::string name = metric.substr(7);
+        uint64_t first_start = UINT64_MAX, last_end = 0, bytes = 0;
+        for (const TestResult& r : results) {
+            auto it = r.regions.find(name);
+            if (it == r.regions.end()) continue;
+            first_start = std::min(first_start, it->second.start_ns);
+            last_end = std::max(last_end, it->second.end_ns);
+            bytes += it->second.bytes;
+        }
+        if (last_end <= first_start) return missing;
+        return bytes / (1024.0 * 1024.0 * 1024.0) / ((last_end - first_start) / 1.0e9);
+    }
+    double sum = 0;
+    bool found = false;
+    for (const TestResult& r : results) {
+        auto it = r.metrics.find(metric);
+        if (it == r.metrics.end()) continue;
+        sum += it->second.as_double();
+        found = true;
+    }
+    return found ? sum : missing;
+}
+
+} // namespace
+
+struct GrpcClientManager::Call {
+    size_t index; // Into worker_contexts
+    size_t worker;
+    uint64_t request_id;
+};
+
+GrpcClientManager::GrpcClientManager(std::shared_ptr<ServerCommunicator> server_communicator,
+                                     std::string test_name,
+                                     uint64_t min_start_margin_ns)
+    : server_communicator_(std::move(server_communicator)),
+      slots_(server_communicator_->live_workers()),
+      test_name_(std::move(test_name)),
+      min_start_margin_ns_(min_start_margin_ns) {}
+
+void GrpcClientManager::to_server_clock(size_t worker, TestResult& result) const {
+    auto it = clock_offsets_.find(worker);
+    if (it == clock_offsets_.end()) return;
+    for (auto& [name, region] : result.regions) {
+        region.start_ns -= it->second.offset_ns;
+        region.end_ns -= it->second.offset_ns;
+    }
+    for (ProgressSample& sample : result.timeline) sample.t_ns -= it->second.offset_ns;
+    result.metrics["clock_offset_ns"] = it->second.offset_ns;
+    result.metrics["clock_rtt_ns"] = it->second.rtt_ns;
+}
+
+std::vector<TestResult> GrpcClientManager::broadcast(const std::vector<TestContext>& worker_contexts,
+                                                     int phase, uint64_t start_at_ns) {
+    // 1. Queue every request first; the stream reactors send them concurrently.
+    std::vector<Call> calls;
+    std::vector<TestResult> results(worker_contexts.size());
+    calls.reserve(worker_contexts.size());
+    for (size_t i = 0; i < worker_contexts.size(); ++i) {
+        const TestContext& context = worker_contexts[i];
+        size_t worker = static_cast<size_t>(context.worker_id);
+        if (worker >= slots_.size()) {
+            results[i] = {false, "Worker " + std::to_string(worker) + " is not connected"};
+            continue;
+        }
+        hpcfs_bench::TestParams params;
+        params.set_test_name(test_name_);
+        params.set_phase(static_cast<hpcfs_bench::Phase>(phase));
+        if (start_at_ns) {
+            // Same instant, expressed on the worker's clock.
+            auto it = clock_offsets_.find(worker);
+            params.set_start_at_ns(start_at_ns + (it == clock_offsets_.end() ? 0 : it->second.offset_ns));
+        }
+        to_proto(context, &params);
+        if (phase == hpcfs_bench::EXECUTE) {
+            auto it = context.params.find("progress_interval_ms");
+            params.set_progress_interval_ms(it == context.params.end() ? progress_interval_ms_ : std::stoul(it->second));
+        }
+        calls.push_back({i, worker, server_communicator_->send_to(slots_[worker], std::move(params))});
+    }
+
+    // 2. Then collect, in the order results arrive: each one is converted
+    //    while slower workers are still running, instead of waiting behind
+    //    whichever worker comes first in the list.
+    const uint64_t deadline_ns = timeout_ns_ ? now_ns() + timeout_ns_ : 0;
+    std::map<size_t, std::deque<const Call*>> pending; // slot -> its calls, oldest first
+    for (const Call& call : calls) pending[slots_[call.worker]].push_back(&call);
+    std::vector<size_t> waiting;
+    while (!pending.empty()) {
+        waiting.clear();
+        for (const auto& [slot, queue] : pending) waiting.push_back(slot);
+        hpcfs_bench::TestResult msg;
+        size_t slot = server_communicator_->receive_any(waiting, msg, deadline_ns);
+        if (slot == ServerCommunicator::NO_WORKER) {
+            // Fail whoever can't answer any more, then keep waiting for the rest.
+            bool timed_out = deadline_ns && now_ns() >= deadline_ns;
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (!timed_out && server_communicator_->is_connected(it->first)) {
+                    ++it;
+                    continue;
+                }
+                for (const Call* call : it->second) {
+                    results[call->index] = {false, "Worker " + std::to_string(call->worker) +
+                                                   (timed_out ? " timed out" : " disconnected")};
+                }
+                it = pending.erase(it);
+            }
+            continue;
+        }
+        std::deque<const Call*>& queue = pending[slot];
+        const Call& call = *queue.front();
+        if (msg.request_id() != call.request_id) {
+            // Each worker runs its requests in order: a leftover from an earlier, abandoned call.
+            std::cout << "Worker " << call.worker << ": dropping stale result " << msg.request_id() << std::endl;
+            continue;
+        }
+        queue.pop_front();
+        if (queue.empty()) pending.erase(slot);
+        TestResult& result = results[call.index];
+        from_proto(msg, result);
+        // Every sample was read before the result (same stream, in order).
+        for (const auto& sample : server_communicator_->get_progress_log(slot)->take(call.request_id)) {
+            result.timeline.push_back({sample.t_ns(), sample.bytes(), sample.ops()});
+        }
+        if (phase == hpcfs_bench::EXECUTE) {
+            to_server_clock(call.worker, result);
+            if (execute_callback_) execute_callback_(call.worker, result);
+        }
+    }
+    return results;
+}
+
+bool GrpcClientManager::rpc_call_setup(size_t worker, const TestContext& context) {
+    TestContext addressed = context;
+    addressed.worker_id = static_cast<int>(worker);
+    return broadcast({addressed}, hpcfs_bench::SETUP, 0)[0].success;
+}
+
+TestResult GrpcClientManager::rpc_call_execute(size_t worker, const TestContext& context) {
+    TestContext addressed = context;
+    addressed.worker_id = static_cast<int>(worker);
+    return broadcast({addressed}, hpcfs_bench::EXECUTE, 0)[0];
+}
+
+void GrpcClientManager::rpc_call_cleanup(size_t worker, const TestContext& context) {
+    TestContext addressed = context;
+    addressed.worker_id = static_cast<int>(worker);
+    broadcast({addressed}, hpcfs_bench::CLEANUP, 0);
+}
+
+bool GrpcClientManager::broadcast_setup(const std::vector<TestContext>& worker_contexts) {
+    bool ok = true;
+    for (const TestResult& result : broadcast(worker_contexts, hpcfs_bench::SETUP, 0)) ok &= result.success;
+    return ok;
+}
+
+void GrpcClientManager::sync_clocks(const std::vector<TestContext>& worker_contexts, unsigned rounds) {
+    std::map<size_t, ClockOffset> best;
+    std::vector<bool> lost(slots_.size(), false); // Missed a probe: not asked again
+    for (unsigned round = 0; round < rounds; ++round) {
+        std::vector<Call> calls;
+        for (size_t i = 0; i < worker_contexts.size(); ++i) {
+            size_t worker = static_cast<size_t>(worker_contexts[i].worker_id);
+            if (worker >= slots_.size() || lost[worker]) continue;
+            hpcfs_bench::TestParams params;
+            params.set_phase(hpcfs_bench::CLOCK_PROBE);
+            calls.push_back({i, worker, server_communicator_->send_to(slots_[worker], std::move(params))});
+        }
+        const uint64_t deadline_ns = timeout_ns_ ? now_ns() + timeout_ns_ : 0;
+        for (const Call& call : calls) {
+            hpcfs_bench::TestResult reply;
+            // A worker that can't answer fails its execute anyway; no offset for it.
+            if (!await_result(*server_communicator_, slots_[call.worker], call.request_id, deadline_ns, reply)) {
+                lost[call.worker] = true;
+                continue;
+            }
+            const hpcfs_bench::ClockProbe& probe = reply.probe();
+            int64_t t1 = probe.server_send_ns(), t2 = probe.worker_recv_ns();
+            int64_t t3 = probe.worker_send_ns(), t4 = probe.server_recv_ns();
+            if (!t1 || !t2 || !t3 || !t4) continue; // Not stamped (e.g. an old worker)
+            int64_t rtt = (t4 - t1) - (t3 - t2);
+            if (rtt < 0) continue;
+            auto it = best.find(call.worker);
+            if (it == best.end() || static_cast<uint64_t>(rtt) < it->second.rtt_ns) {
+                best[call.worker] = {((t2 - t1) + (t3 - t4)) / 2, static_cast<uint64_t>(rtt)};
+            }
+        }
+    }
+    for (const auto& [worker, offset] : best) clock_offsets_[worker] = offset;
+}
+
+std::vector<TestResult> GrpcClientManager::broadcast_execute(const std::vector<TestContext>& worker_contexts) {
+    std::vector<TestContext> unsynced;
+    for (const TestContext& context : worker_contexts) {
+        if (!clock_offsets_.count(static_cast<size_t>(context.worker_id))) unsynced.push_back(context);
+    }
+    if (!unsynced.empty()) sync_clocks(unsynced);
+
+    // Phase 1: arm. The round takes ~ fan-out time + slowest round trip,
+    // which upper-bounds how long the GO fan-out will take to reach everyone.
+    uint64_t arm_start = realtime_ns();
+    std::vector<TestResult> armed = broadcast(worker_contexts, hpcfs_bench::ARM, 0);
+    uint64_t arm_round_ns = realtime_ns() - arm_start;
+    for (const TestResult& result : armed) {
+        if (!result.success) return armed;
+    }
+
+    // Phase 2: go.
+    uint64_t margin_ns = std::max(min_start_margin_ns_, 2 * arm_round_ns);
+
+    // broadcast() already moved every region onto the server's clock.
+    return broadcast(worker_contexts, hpcfs_bench::EXECUTE, realtime_ns() + margin_ns);
+}
+
+void GrpcClientManager::broadcast_cleanup(const std::vector<TestContext>& worker_contexts) {
+    broadcast(worker_contexts, hpcfs_bench::CLEANUP, 0);
+}
+
+GrpcClientManager::IterationPolicy GrpcClientManager::IterationPolicy::from_params(
+    const std::map<std::string, std::string>& params, const IterationPolicy& defaults
+) {
+    IterationPolicy policy = defaults;
+    auto get = [&](const char* key) -> const std::string* {
+        auto it = params.find(key);
+        return it == params.end() ? nullptr : &it->second;
+    };
+    if (auto v = get("iterations_warmup")) policy.warmup = std::stoul(*v);
+    if (auto v = get("iterations_min")) policy.min_iterations = std::stoul(*v);
+    if (auto v = get("iterations_max")) policy.max_iterations = std::stoul(*v);
+    if (auto v = get("iterations_rel_ci")) policy.target_rel_ci = std::stod(*v);
+    if (auto v = get("iterations_budget_s")) policy.budget_s = std::stod(*v);
+    if (auto v = get("iterations_metric")) policy.metric = *v;
+    return policy;
+}
+
+std::vector<TestResult> GrpcClientManager::execute_iterations(const std::vector<TestContext>& worker_contexts,
+                                                              const IterationPolicy& policy) {
+    const uint64_t deadline = policy.budget_s > 0 ? realtime_ns() + static_cast<uint64_t>(policy.budget_s * 1e9) : 0;
+    std::vector<TestContext> contexts = worker_contexts;
+    int iteration = 0;
+    auto execute = [&] {
+        for (TestContext& context : contexts) context.iteration = iteration;
+        iteration++;
+        return broadcast_execute(contexts);
+    };
+    auto all_ok = [](const std::vector<TestResult>& results) {
+        return std::all_of(results.begin(), results.end(), [](const TestResult& r) { return r.success; });
+    };
+
+    std::vector<TestResult> results;
+    unsigned warmed_up = 0;
+    while (warmed_up < policy.warmup) {
+        results = execute();
+        if (!all_ok(results)) return results;
+        warmed_up++;
+        if (deadline && realtime_ns() >= deadline) break;
+    }
+
+    // At least one measured iteration, even if warmup used up the budget.
+    std::vector<double> values;
+    double mean = 0, stddev = 0, ci = 0, rel_ci = std::numeric_limits<double>::infinity();
+    bool converged = false;
+    for (;;) {
+        results = execute();
+        if (!all_ok(results)) return results;
+        double value = primary_metric(results, policy.metric);
+        if (std::isnan(value)) break; // Nothing to converge on
+        values.push_back(value);
+
+        size_t n = values.size();
+        double sum = 0, sum_sq = 0;
+        for (double v : values) sum += v;
+        mean = sum / n;
+        for (double v : values) sum_sq += (v - mean) * (v - mean);
+        stddev = n > 1 ? std::sqrt(sum_sq / (n - 1)) : 0.0;
+        ci = n > 1 ? t_critical_95(n - 1) * stddev / std::sqrt(static_cast<double>(n)) : 0.0;
+        rel_ci = n > 1 && mean != 0 ? ci / std::fabs(mean) : std::numeric_limits<double>::infinity();
+
+        if (n >= std::max(policy.min_iterations, 2u) && rel_ci <= policy.target_rel_ci) {
+            converged = true;
+            break;
+        }
+        if (n >= policy.max_iterations) break;
+        if (deadline && realtime_ns() >= deadline) break;
+    }
+
+    for (TestResult& result : results) {
+        result.metrics["iter_metric"] = policy.metric.empty() ? "duration_s" : policy.metric;
+        result.metrics["iter_count"] = values.size();
+        result.metrics["iter_warmup"] = warmed_up;
+        result.metrics["iter_mean"] = mean;
+        result.metrics["iter_stddev"] = stddev;
+        result.metrics["iter_ci95"] = ci;
+        result.metrics["iter_rel_ci"] = rel_ci;
+        result.metrics["iter_converged"] = converged ? 1 : 0;
+        result.metrics["iter_values"] = values;
+    }
+    return results;
+}
+
+std::vector<TestResult> GrpcClientManager::run_all(const std::vector<TestContext>& worker_contexts) {
+    std::vector<TestResult> results = broadcast(worker_contexts, hpcfs_bench::SETUP, 0);
+    bool setup_ok = std::all_of(results.begin(), results.end(), [](const TestResult& r) { return r.success; });
+    if (setup_ok) {
+        IterationPolicy policy = worker_contexts.empty()
+            ? iteration_policy_
+            : IterationPolicy::from_params(worker_contexts[0].params, iteration_policy_);
+        bool repeat = policy.warmup > 0 || policy.max_iterations > 1;
+        results = repeat ? execute_iterations(worker_contexts, policy) : broadcast_execute(worker_contexts);
+    }
+    broadcast_cleanup(worker_contexts);
+    return results;
+}
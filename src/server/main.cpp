@@ -1,5 +1,15 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <grpc/grpc.h>
 #include <grpcpp/security/server_credentials.h>
@@ -7,117 +17,366 @@
 #include <grpcpp/server_builder.h>
 #include <grpcpp/server_context.h>
 
-#include "../comm_utils/communicator.hpp"
+#include "server_communicator.hpp"
+#include "streaming_aggregator.hpp"
+#include "../comm_utils/clock.hpp"
+#include "../fs_test/grpc_client_manager.hpp"
+#include "../fs_test/proto_convert.hpp"
+#include "../fs_test/test_registry.hpp"
+#include "../result_store/result_store.hpp"
 
 #include "../../protos/hpcfs_bench.pb.h"
 #include "../../protos/hpcfs_bench.grpc.pb.h"
 
 
 
-class ServerCommunicator {
-private:
-    std::vector<std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>> communicators;
-public:
-    ServerCommunicator() {}
-    std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>> create_communicator() {
-        auto comm = std::make_shared<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>();
-        communicators.push_back(comm);
-        return comm;
-    }
-    void send_to(size_t index, hpcfs_bench::TestParams&& params) {
-        communicators[index]->queue_send(params);
-    }
-    hpcfs_bench::TestResult&& receive_from(size_t index) {
-        return communicators[index]->receive();
-    }
-};
-
-
+/**
+ * @brief Server end of one worker's Comm stream.
+ *
+ * Keeps up to `window` tests in flight: a new TestParams is written as soon
+ * as the previous write finished and fewer than `window` results are
+ * outstanding, and a read is always pending. Results are matched to their
+ * params by request_id. Nothing here blocks: new params arrive through the
+ * communicator's send notifier and are pulled with try_pop(), and a result
+ * that finds the receive queue full is held back, with the stream's next
+ * read, until the communicator's drain notifier says the consumer made room.
+ *
+ * window = 1 reproduces the old lockstep behaviour.
+ */
 class ClusterServiceReactor : public grpc::ServerBidiReactor<hpcfs_bench::TestResult, hpcfs_bench::TestParams> {
 private:
+    std::mutex mtx;
+    bool write_in_progress = false;
     bool done = false;
+    const size_t window;
 
     hpcfs_bench::TestParams params;
     hpcfs_bench::TestResult result;
-    
+    /** @brief request_id -> dispatch time (ns) of every test awaiting its result. */
+    std::unordered_map<uint64_t, uint64_t> in_flight;
+    /** @brief Guards read_stalled; held across try_queue_receive() so a drain can't slip in between. */
+    std::mutex stall_mtx;
+    /** @brief `result` is waiting for room in the receive queue; no read is pending. */
+    bool read_stalled = false;
+
     std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>> communicator;
+    std::shared_ptr<DispatchStats> stats;
+    std::shared_ptr<ProgressLog> progress;
+    /** @brief Tells the ServerCommunicator this worker is gone; runs at most once. */
+    std::function<void()> on_disconnect;
 
-public:
-    ClusterServiceReactor(const std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>& communicator): communicator(communicator) {
-        std::cout << "Reactor created" << std::endl;
-        params = communicator->send();
+    void disconnect() {
+        if (on_disconnect) on_disconnect();
+        on_disconnect = nullptr;
+    }
+
+    /**
+     * @brief Starts the next write if the stream is idle and the window has room.
+     *
+     * StartWrite() is called after releasing mtx, since gRPC may run
+     * OnWriteDone() inline.
+     */
+    void try_start_write() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (done || write_in_progress || in_flight.size() >= window) return;
+            if (!communicator->get_send_queue().try_pop(params)) return;
+            write_in_progress = true;
+            uint64_t now = now_ns();
+            in_flight.emplace(params.request_id(), now);
+            uint64_t unset = 0;
+            stats->first_dispatch_ns.compare_exchange_strong(unset, now);
+            stats->dispatched++;
+        }
+        // Stamp clock probes last thing before they hit the wire.
+        if (params.phase() == hpcfs_bench::CLOCK_PROBE) params.mutable_probe()->set_server_send_ns(realtime_ns());
         StartWrite(&params);
     }
-    void OnReadDone(bool ok) override {
-        if (ok) {
-            // put the results in the receive queue
-            communicator->queue_receive(result);
 
-            // get next params to send
-            params = communicator->send();
-            // send params
-            StartWrite(&params);
-        } else {
-            std::cout << "No more TestParams from client." << std::endl;
+    /** @brief Drain notifier: queues the held-back result, if any, and resumes reading. */
+    void resume_read() {
+        {
+            std::lock_guard<std::mutex> lock(stall_mtx);
+            if (!read_stalled || !communicator->try_queue_receive(std::move(result))) return;
+            read_stalled = false;
         }
+        result.Clear();
+        StartRead(&result);
     }
-    void OnWriteDone(bool ok) override {
-        if (ok) {
+
+public:
+    ClusterServiceReactor(
+        const std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>& communicator,
+        const std::shared_ptr<DispatchStats>& stats,
+        const std::shared_ptr<ProgressLog>& progress,
+        std::function<void()> on_disconnect,
+        size_t window
+    ): window(std::max<size_t>(window, 1)), communicator(communicator), stats(stats), progress(progress),
+       on_disconnect(std::move(on_disconnect)) {
+        std::cout << "Reactor created (window " << this->window << ")" << std::endl;
+        communicator->set_send_notifier([this] { try_start_write(); });
+        communicator->set_drain_notifier([this] { resume_read(); });
+        StartRead(&result);
+        try_start_write();
+    }
+    void OnReadDone(bool ok) override {
+        if (!ok) {
+            std::cout << "No more TestResults from client." << std::endl;
+            disconnect();
+            return;
+        }
+        if (result.has_progress()) {
+            // A sample from a test still running: not a completion, so it
+            // neither frees a window slot nor goes to the receive queue.
+            progress->append(result.request_id(), result.progress());
+            result.Clear();
+            StartRead(&result);
+            return;
+        }
+        if (result.has_probe()) result.mutable_probe()->set_server_recv_ns(realtime_ns());
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = in_flight.find(result.request_id());
+            if (it == in_flight.end()) {
+                std::cout << "Dropping TestResult with unknown request_id " << result.request_id() << std::endl;
+            } else {
+                in_flight.erase(it);
+                stats->completed++;
+                stats->last_complete_ns = now_ns();
+            }
+        }
+        // put the results in the receive queue; if it is full, stop reading
+        // until the consumer drains it (resume_read()) rather than block here
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lock(stall_mtx);
+            queued = communicator->try_queue_receive(std::move(result));
+            read_stalled = !queued;
+        }
+        if (queued) {
+            result.Clear();
             // read next result
             StartRead(&result);
-        } else {
+        }
+        // refill the window it just freed
+        try_start_write();
+    }
+    void OnWriteDone(bool ok) override {
+        if (!ok) {
             std::cout << "Failed to send TestParams." << std::endl;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            write_in_progress = false;
         }
+        try_start_write();
     }
     void OnDone() override {
-        std::cout << "Reactor done" << std::endl;
-        done = true;
+        std::cout << "Reactor done (" << stats->completed << " tests, "
+                  << stats->tests_per_sec() << " tests/s)" << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+        }
+        // Once this returns no notifier call can be running, so it is safe to delete.
+        communicator->set_send_notifier(nullptr);
+        communicator->set_drain_notifier(nullptr);
+        disconnect();
+        delete this;
     }
 };
 
 
-class ClusterService : public hpcfs_bench::ClusterService::Service {
+class ClusterService : public hpcfs_bench::ClusterService::CallbackService {
 private:
     std::shared_ptr<ServerCommunicator> server_communicator;
+    size_t window;
 public:
-    ClusterService(const std::shared_ptr<ServerCommunicator>& server_communicator): server_communicator(server_communicator) {}
-    grpc::ServerBidiReactor< hpcfs_bench::TestResult, hpcfs_bench::TestParams>* Comm(grpc::CallbackServerContext* context) {
-        ClusterServiceReactor* reactor = new ClusterServiceReactor(server_communicator->create_communicator());
-        return reactor;
+    ClusterService(const std::shared_ptr<ServerCommunicator>& server_communicator, size_t window)
+        : server_communicator(server_communicator), window(window) {}
+    grpc::ServerBidiReactor< hpcfs_bench::TestResult, hpcfs_bench::TestParams>* Comm(grpc::CallbackServerContext* context) override {
+        size_t index = server_communicator->create_communicator();
+        return new ClusterServiceReactor(
+            server_communicator->get_communicator(index),
+            server_communicator->get_dispatch_stats(index),
+            server_communicator->get_progress_log(index),
+            [server_communicator = server_communicator, index] { server_communicator->disconnect(index); },
+            window
+        );
     }
 };
 
 
-class ControllerReactor : public grpc::ServerUnaryReactor<hpcfs_bench::TestParams, hpcfs_bench::TestBatchResult> {
-
-}
+/**
+ * @brief Answers one RunTests call from its own thread, so a test running
+ * for minutes never holds a gRPC callback thread.
+ */
+class ControllerReactor : public grpc::ServerUnaryReactor {
+public:
+    explicit ControllerReactor(std::function<grpc::Status()> work) {
+        std::thread([this, work = std::move(work)] { Finish(work()); }).detach();
+    }
+    void OnDone() override {
+        delete this;
+    }
+};
 
 
-class ControllerService : public hpcfs_bench::ControllerService::Service {
+/**
+ * @brief Runs a whole test on the connected workers: global_setup(),
+ * global_execute(), global_cleanup(), then the TestBatchResult.
+ *
+ * The request's test_name picks the test and its params are the test's
+ * config; "num_workers" defaults to the number of workers connected right
+ * now, and "timeout_s" (default none) bounds how long any one phase waits
+ * for its results. A worker that disconnects fails instead of hanging the
+ * run. Tests share the workers, so concurrent calls run one after another.
+ */
+class ControllerService : public hpcfs_bench::ControllerService::CallbackService {
 private:
     std::shared_ptr<ServerCommunicator> server_communicator;
+    /** @brief Where every finished run is appended; null when --results isn't given. */
+    std::shared_ptr<result_store::Writer> results;
+    std::mutex run_mtx;
+
+    grpc::Status run_test(const hpcfs_bench::TestParams& request, hpcfs_bench::TestBatchResult* response) {
+        std::lock_guard<std::mutex> lock(run_mtx);
+        TestContext config;
+        from_proto(request, config);
+        config.worker_id = -1;
+        // Only workers connected now take part; a dead slot would never answer.
+        GrpcClientManager grpc_clients(server_communicator, request.test_name());
+        config.params.emplace("num_workers", std::to_string(grpc_clients.num_workers()));
+        auto timeout = config.params.find("timeout_s");
+        if (timeout != config.params.end()) grpc_clients.set_timeout_s(std::stod(timeout->second));
+        std::unique_ptr<BaseTest> test = TestRegistry::instance().create(request.test_name(), config);
+        if (!test) return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown test: " + request.test_name());
+
+        std::vector<TestContext> worker_contexts;
+        if (!test->global_setup(worker_contexts)) {
+            test->global_cleanup();
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "global_setup failed");
+        }
+        for (const TestContext& context : worker_contexts) {
+            if (context.worker_id < 0 || static_cast<size_t>(context.worker_id) >= grpc_clients.num_workers()) {
+                test->global_cleanup();
+                return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                    "Worker " + std::to_string(context.worker_id) + " is not connected");
+            }
+        }
+        StreamingAggregator aggregator(worker_contexts.size());
+        grpc_clients.set_execute_callback([&](size_t worker, const TestResult&) { aggregator.arrived(worker); });
+        std::vector<TestResult> worker_results = test->global_execute(grpc_clients, worker_contexts);
+        test->global_cleanup();
+
+        for (size_t i = 0; i < worker_results.size(); ++i) {
+            hpcfs_bench::TestResult msg;
+            to_proto(worker_results[i], &msg);
+            aggregator.add(i, std::move(msg));
+        }
+        aggregator.finish();
+        *response = std::move(aggregator.batch());
+        if (results) results->append({request.test_name(), 0, config.params, std::move(worker_results)});
+
+        const hpcfs_bench::BatchSummary& summary = response->summary();
+        std::cout << request.test_name() << ": " << summary.workers() << " workers, "
+                  << summary.failed() << " failed, slowest " << summary.duration_s().max()
+                  << " s (worker " << summary.duration_s().max_worker() << ")" << std::endl;
+        return grpc::Status::OK;
+    }
+
 public:
-    ControllerService(const std::shared_ptr<ServerCommunicator>& server_communicator): server_communicator(server_communicator) {}
-    grpc::ServerUnaryReactor* RunTests(grpc::ServerContext* context, const hpcfs_bench::TestParams* request, hpcfs_bench::TestBatchResult* response) override {
-        return new ControllerReactor();
+    ControllerService(const std::shared_ptr<ServerCommunicator>& server_communicator,
+                      const std::shared_ptr<result_store::Writer>& results)
+        : server_communicator(server_communicator), results(results) {}
+    grpc::ServerUnaryReactor* RunTests(grpc::CallbackServerContext* context, const hpcfs_bench::TestParams* request,
+                                       hpcfs_bench::TestBatchResult* response) override {
+        return new ControllerReactor([this, request, response] { return run_test(*request, response); });
     }
 };
 
-void run_server() {
+/**
+ * @brief Measures raw dispatch overhead: sends `num_tests` no-op tests
+ * (test_index UNKNOWN, which workers answer immediately) to each of the
+ * first `num_workers` workers and reports tests/sec per worker.
+ *
+ * Run once with --window 1 (lockstep) and once with a larger window to
+ * compare.
+ */
+void run_dispatch_bench(const std::shared_ptr<ServerCommunicator>& server_communicator,
+                        size_t num_workers, size_t num_tests) {
+    std::cout << "Dispatch bench: waiting for " << num_workers << " worker(s)..." << std::endl;
+    while (server_communicator->size() < num_workers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t w = 0; w < num_workers; ++w) {
+        for (size_t i = 0; i < num_tests; ++i) {
+            server_communicator->send_to(w, hpcfs_bench::TestParams());
+        }
+    }
+    std::vector<size_t> workers(num_workers);
+    for (size_t w = 0; w < num_workers; ++w) workers[w] = w;
+    hpcfs_bench::TestResult result;
+    for (size_t i = 0; i < num_workers * num_tests; ++i) server_communicator->receive_any(workers, result);
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t w = 0; w < num_workers; ++w) {
+        std::cout << "  worker " << w << ": "
+                  << server_communicator->get_dispatch_stats(w)->tests_per_sec() << " tests/s" << std::endl;
+    }
+    std::cout << "  total: " << (num_workers * num_tests) / elapsed_s << " tests/s" << std::endl;
+}
+
+void run_server(size_t window, size_t bench_workers, size_t bench_tests,
+                const std::shared_ptr<result_store::Writer>& results) {
     std::string server_address("0.0.0.0:8000");
     std::shared_ptr<ServerCommunicator> server_communicator = std::make_shared<ServerCommunicator>();
-    
-    ClusterService service(server_communicator);
+
+    ClusterService service(server_communicator, window);
+    ControllerService controller(server_communicator, results);
     grpc::ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     builder.RegisterService(&service);
+    builder.RegisterService(&controller);
 
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    if (bench_tests > 0) {
+        std::thread([=] { run_dispatch_bench(server_communicator, bench_workers, bench_tests); }).detach();
+    }
     server->Wait();
 }
 
 
-int main() {
-    run_server();
+/**
+ * Usage: server.exe [--window K] [--dispatch-bench N] [--workers W] [--results PATH]
+ *   --window K          Max tests in flight per worker stream (default 8; 1 = lockstep).
+ *   --dispatch-bench N  Send N no-op tests to each of W workers and report tests/sec.
+ *   --results PATH      Append every run to the result store at PATH (read it with result_dump).
+ */
+int main(int argc, char** argv) {
+    size_t window = 8;
+    size_t bench_tests = 0;
+    size_t bench_workers = 1;
+    std::shared_ptr<result_store::Writer> results;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        size_t value = std::strtoul(argv[i + 1], nullptr, 10);
+        if (flag == "--results") {
+            results = std::make_shared<result_store::Writer>();
+            if (!results->open(argv[i + 1])) {
+                std::cerr << "Cannot open result store " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        }
+        else if (flag == "--window") window = value;
+        else if (flag == "--dispatch-bench") bench_tests = value;
+        else if (flag == "--workers") bench_workers = value;
+        else {
+            std::cerr << "Unknown flag: " << flag << std::endl;
+            return 1;
+        }
+    }
+    run_server(window, bench_workers, bench_tests, results);
     return 0;
 }
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../fs_test/proto_convert.hpp"
+
+#include "../../protos/hpcfs_bench.pb.h"
+
+/**
+ * @brief Merges every worker's histograms into one cluster-wide histogram per operation.
+ *
+ * Histograms that fail to decode (e.g. a worker built with a different
+ * bucket layout) are skipped rather than poisoning the merged result.
+ */
+inline std::map<std::string, std::unique_ptr<LatencyHistogram>> merge_worker_histograms(
+    const google::protobuf::RepeatedPtrField<hpcfs_bench::TestResult>& results
+) {
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> merged;
+    // One scratch histogram for decoding: they are ~30KB, keep them off the stack.
+    auto scratch = std::make_unique<LatencyHistogram>();
+    for (const auto& result : results) {
+        for (const auto& [name, msg] : result.histograms()) {
+            if (!from_proto(msg, *scratch)) continue;
+            auto& slot = merged[name];
+            if (!slot) slot = std::make_unique<LatencyHistogram>();
+            slot->merge(*scratch);
+        }
+    }
+    return merged;
+}
+
+inline void to_summary(const LatencyHistogram& hist, hpcfs_bench::LatencySummary* out) {
+    out->set_count(hist.count());
+    out->set_mean(hist.mean());
+    out->set_p50(hist.percentile(50.0));
+    out->set_p99(hist.percentile(99.0));
+    out->set_p999(hist.percentile(99.9));
+    out->set_max(hist.max());
+}
+
+/**
+ * @brief Fills batch->cluster_latency from the worker results already in batch->resuts.
+ */
+inline void summarize_cluster_latency(hpcfs_bench::TestBatchResult* batch) {
+    auto merged = merge_worker_histograms(batch->resuts());
+    auto* summaries = batch->mutable_cluster_latency();
+    for (const auto& [name, hist] : merged) {
+        to_summary(*hist, &(*summaries)[name]);
+    }
+}
+
+/**
+ * @brief Fills batch->cluster_regions from the workers' TimedRegions.
+ *
+ * Regions must already be on the server's clock (GrpcClientManager does
+ * this). For each region name:
+ * - aggregate_gbps is total bytes / (last end - first start), the bandwidth
+ *   the filesystem actually delivered, rather than a sum of per-worker rates
+ *   that assumes everyone ran at the same time;
+ * - overlap_pct is how much of that span had every worker running at once;
+ * - a worker is a straggler if it finished more than straggler_fraction of
+ *   the median duration after the median finish time.
+ */
+inline void summarize_cluster_regions(hpcfs_bench::TestBatchResult* batch, double straggler_fraction = 0.1) {
+    struct Entry {
+        uint32_t worker;
+        uint64_t start_ns;
+        uint64_t end_ns;
+        uint64_t bytes;
+    };
+    std::map<std::string, std::vector<Entry>> by_name;
+    for (int i = 0; i < batch->resuts_size(); ++i) {
+        for (const auto& [name, region] : batch->resuts(i).regions()) {
+            if (region.end_ns() < region.start_ns()) continue;
+            by_name[name].push_back({static_cast<uint32_t>(i), region.start_ns(), region.end_ns(), region.bytes()});
+        }
+    }
+
+    auto* summaries = batch->mutable_cluster_regions();
+    for (auto& [name, entries] : by_name) {
+        uint64_t first_start = UINT64_MAX, last_start = 0;
+        uint64_t first_end = UINT64_MAX, last_end = 0;
+        uint64_t total_bytes = 0;
+        for (const Entry& e : entries) {
+            first_start = std::min(first_start, e.start_ns);
+            last_start = std::max(last_start, e.start_ns);
+            first_end = std::min(first_end, e.end_ns);
+            last_end = std::max(last_end, e.end_ns);
+            total_bytes += e.bytes;
+        }
+        uint64_t span_ns = last_end - first_start;
+        uint64_t overlap_ns = first_end > last_start ? first_end - last_start : 0;
+
+        hpcfs_bench::RegionSummary& summary = (*summaries)[name];
+        summary.set_workers(entries.size());
+        summary.set_total_bytes(total_bytes);
+        summary.set_first_start_ns(first_start);
+        summary.set_last_end_ns(last_end);
+        summary.set_aggregate_gbps(span_ns ? total_bytes / (1024.0 * 1024.0 * 1024.0) / (span_ns / 1.0e9) : 0.0);
+        summary.set_overlap_pct(span_ns ? 100.0 * overlap_ns / span_ns : 0.0);
+        summary.set_start_skew_ns(last_start - first_start);
+
+        std::vector<uint64_t> ends, durations;
+        for (const Entry& e : entries) {
+            ends.push_back(e.end_ns);
+            durations.push_back(e.end_ns - e.start_ns);
+        }
+        std::nth_element(ends.begin(), ends.begin() + ends.size() / 2, ends.end());
+        std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+        uint64_t median_end = ends[ends.size() / 2];
+        uint64_t late_ns = static_cast<uint64_t>(durations[durations.size() / 2] * straggler_fraction);
+        for (const Entry& e : entries) {
+            if (e.end_ns > median_end + late_ns) summary.add_stragglers(e.worker);
+        }
+    }
+}
+
+/**
+ * @brief Fills batch->cluster_timeline with the cluster's cumulative progress.
+ *
+ * Workers sample at their own instants, so their series are resampled onto
+ * one grid of `interval_ns` steps (inferred from the first timeline if 0):
+ * at each grid point, every worker contributes its latest sample at or
+ * before that point. Differences between consecutive points give the
+ * cluster's throughput per interval.
+ */
+inline void summarize_cluster_timeline(hpcfs_bench::TestBatchResult* batch, uint64_t interval_ns = 0) {
+    uint64_t first = UINT64_MAX, last = 0;
+    for (const auto& result : batch->resuts()) {
+        const auto& timeline = result.timeline();
+        if (timeline.empty()) continue;
+        first = std::min(first, timeline.begin()->t_ns());
+        last = std::max(last, timeline.rbegin()->t_ns());
+        if (interval_ns == 0 && timeline.size() > 1) {
+            interval_ns = (timeline.rbegin()->t_ns() - timeline.begin()->t_ns()) / (timeline.size() - 1);
+        }
+    }
+    batch->clear_cluster_timeline();
+    if (first > last || interval_ns == 0) return;
+
+    // One cursor per worker; the grid only moves forward, so each advances monotonically.
+    std::vector<int> cursor(batch->resuts_size(), -1);
+    for (uint64_t t = first;; t += interval_ns) {
+        t = std::min(t, last);
+        hpcfs_bench::ProgressSample* point = batch->add_cluster_timeline();
+        point->set_t_ns(t);
+        for (int w = 0; w < batch->resuts_size(); ++w) {
+            const auto& timeline = batch->resuts(w).timeline();
+            while (cursor[w] + 1 < timeline.size() && timeline[cursor[w] + 1].t_ns() <= t) ++cursor[w];
+            if (cursor[w] < 0) continue;
+            point->set_bytes(point->bytes() + timeline[cursor[w]].bytes());
+            point->set_ops(point->ops() + timeline[cursor[w]].ops());
+        }
+        if (t == last) break;
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../comm_utils/clock.hpp"
+#include "../comm_utils/communicator.hpp"
+
+#include "../../protos/hpcfs_bench.pb.h"
+
+
+/**
+ * @brief Per-worker dispatch counters, kept alive independently of the reactor.
+ */
+struct DispatchStats {
+    std::atomic<uint64_t> dispatched{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> first_dispatch_ns{0};
+    std::atomic<uint64_t> last_complete_ns{0};
+    /** @brief Cleared once the worker's stream ends; its slot is never reused. */
+    std::atomic<bool> connected{true};
+
+    /** @brief Completed tests per second between the first dispatch and the last result. */
+    double tests_per_sec() const {
+        uint64_t first = first_dispatch_ns.load();
+        uint64_t last = last_complete_ns.load();
+        return (last > first) ? completed.load() / ((last - first) / 1.0e9) : 0.0;
+    }
+};
+
+
+/**
+ * @brief Progress samples a worker streamed while running, by request_id.
+ *
+ * The stream reactor appends as samples arrive; whoever awaits the request
+ * takes the series once the final result is in.
+ */
+class ProgressLog {
+private:
+    std::mutex mtx;
+    std::map<uint64_t, std::vector<hpcfs_bench::ProgressSample>> series;
+public:
+    void append(uint64_t request_id, const hpcfs_bench::ProgressSample& sample) {
+        std::lock_guard<std::mutex> lock(mtx);
+        series[request_id].push_back(sample);
+    }
+    /** @brief Removes and returns the samples of one request (oldest first). */
+    std::vector<hpcfs_bench::ProgressSample> take(uint64_t request_id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = series.find(request_id);
+        if (it == series.end()) return {};
+        std::vector<hpcfs_bench::ProgressSample> out = std::move(it->second);
+        series.erase(it);
+        return out;
+    }
+};
+
+
+class ServerCommunicator {
+private:
+    std::mutex mtx;
+    std::vector<std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>> communicators;
+    std::vector<std::shared_ptr<DispatchStats>> dispatch_stats;
+    std::vector<std::shared_ptr<ProgressLog>> progress_logs;
+    std::atomic<uint64_t> next_request_id{1};
+
+    // Bumped after a result lands in any receive queue; receive_any() waits on it.
+    std::mutex arrival_mtx;
+    std::condition_variable arrival_cv;
+    uint64_t arrivals = 0;
+    std::atomic<size_t> scan_start{0};
+public:
+    ServerCommunicator() {}
+    size_t create_communicator() {
+        std::lock_guard<std::mutex> lock(mtx);
+        communicators.push_back(std::make_shared<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>>());
+        communicators.back()->set_receive_notifier([this] {
+            {
+                std::lock_guard<std::mutex> lock(arrival_mtx);
+                arrivals++;
+            }
+            arrival_cv.notify_all();
+        });
+        dispatch_stats.push_back(std::make_shared<DispatchStats>());
+        progress_logs.push_back(std::make_shared<ProgressLog>());
+        return communicators.size() - 1;
+    }
+    std::shared_ptr<Communicator<hpcfs_bench::TestParams, hpcfs_bench::TestResult>> get_communicator(size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return communicators[index];
+    }
+    std::shared_ptr<DispatchStats> get_dispatch_stats(size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return dispatch_stats[index];
+    }
+    std::shared_ptr<ProgressLog> get_progress_log(size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return progress_logs[index];
+    }
+    /** @brief Number of slots ever created, disconnected workers included. */
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return communicators.size();
+    }
+    /** @brief Slots whose worker is still connected, in slot order. */
+    std::vector<size_t> live_workers() {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<size_t> live;
+        for (size_t i = 0; i < dispatch_stats.size(); ++i) {
+            if (dispatch_stats[i]->connected) live.push_back(i);
+        }
+        return live;
+    }
+    bool is_connected(size_t index) {
+        return get_dispatch_stats(index)->connected;
+    }
+    /** @brief Called by the stream reactor when its worker goes away; wakes receive_any(). */
+    void disconnect(size_t index) {
+        get_dispatch_stats(index)->connected = false;
+        {
+            std::lock_guard<std::mutex> lock(arrival_mtx);
+            arrivals++;
+        }
+        arrival_cv.notify_all();
+    }
+    /**
+     * @brief Queues params for a worker without blocking on the stream.
+     * @return The request id the worker will echo in its TestResult.
+     */
+    uint64_t send_to(size_t index, hpcfs_bench::TestParams&& params) {
+        uint64_t request_id = next_request_id.fetch_add(1);
+        params.set_request_id(request_id);
+        get_communicator(index)->queue_send(std::move(params));
+        return request_id;
+    }
+    hpcfs_bench::TestResult receive_from(size_t index) {
+        return get_communicator(index)->receive();
+    }
+    /** @brief receive_any() found nothing: a worker disconnected or the deadline passed. */
+    static constexpr size_t NO_WORKER = SIZE_MAX;
+
+    /**
+     * @brief Pops the first result available from any of `workers`, blocking
+     * until one arrives, so a slow worker never holds up the others' results.
+     *
+     * Each call starts scanning one worker further along, so a busy stream
+     * cannot starve the rest.
+     * @param deadline_ns now_ns() time to give up at; 0 waits for as long as
+     * the workers stay connected.
+     * @return The worker the result came from, or NO_WORKER if one of
+     * `workers` disconnected with nothing left queued, or the deadline passed.
+     */
+    size_t receive_any(const std::vector<size_t>& workers, hpcfs_bench::TestResult& out, uint64_t deadline_ns = 0) {
+        size_t start = scan_start.fetch_add(1);
+        for (;;) {
+            uint64_t seen;
+            {
+                std::lock_guard<std::mutex> lock(arrival_mtx);
+                seen = arrivals;
+            }
+            // Anything queued before `seen` was read is found by this scan;
+            // anything after it changes `arrivals`, so the wait can't miss it.
+            for (size_t k = 0; k < workers.size(); ++k) {
+                size_t worker = workers[(start + k) % workers.size()];
+                if (get_communicator(worker)->try_receive(out)) return worker;
+            }
+            for (size_t worker : workers) {
+                if (!is_connected(worker)) return NO_WORKER;
+            }
+            std::unique_lock<std::mutex> lock(arrival_mtx);
+            auto changed = [&] { return arrivals != seen; };
+            if (deadline_ns == 0) {
+                arrival_cv.wait(lock, changed);
+                continue;
+            }
+            uint64_t now = now_ns();
+            if (now >= deadline_ns) return NO_WORKER;
+            arrival_cv.wait_for(lock, std::chrono::nanoseconds(deadline_ns - now), changed);
+        }
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "result_aggregation.hpp"
+#include "../comm_utils/clock.hpp"
+
+#include "../../protos/hpcfs_bench.pb.h"
+
+/**
+ * @brief Builds a TestBatchResult from worker results in whatever order they arrive.
+ *
+ * add() files each result in its worker's slot of batch().resuts and folds
+ * its duration and scalar metrics into running statistics (Welford's online
+ * mean/variance, min/max and who reported them), so nothing per-worker is
+ * left to do when the last one reports. finish() then only adds what needs
+ * every result at once: the summarize_cluster_* summaries and the stragglers.
+ *
+ * The arrival fields come from arrived(), called as each execute result
+ * reaches the server (GrpcClientManager::set_execute_callback()), not from
+ * add(): a test's final results are only known once global_execute() has
+ * merged its rounds, long after the workers answered.
+ *
+ *     StreamingAggregator aggregator(num_workers);
+ *     grpc_clients.set_execute_callback([&](size_t worker, const TestResult&) { aggregator.arrived(worker); });
+ *     ...
+ *     while (!aggregator.complete()) aggregator.add(worker, std::move(result));
+ *     aggregator.finish();
+ */
+class StreamingAggregator {
+public:
+    /**
+     * @param straggler_fraction A worker is a straggler if its duration
+     * exceeds the median by more than this fraction of the median.
+     */
+    explicit StreamingAggregator(size_t num_workers, double straggler_fraction = 0.1)
+        : straggler_fraction_(straggler_fraction), reported_(num_workers, false), durations_(num_workers, 0) {
+        for (size_t i = 0; i < num_workers; ++i) batch_.add_resuts();
+    }
+
+    /**
+     * @brief Records that an execute result from `worker` just reached the
+     * server. A worker arriving twice starts a new round (another execute
+     * call), so the arrival fields describe the last one.
+     */
+    void arrived(size_t worker) {
+        if (worker >= reported_.size()) return;
+        if (std::find(arrival_order_.begin(), arrival_order_.end(), worker) != arrival_order_.end()) {
+            arrival_order_.clear();
+        }
+        uint64_t now = now_ns();
+        if (arrival_order_.empty()) first_arrival_ns_ = now;
+        last_arrival_ns_ = now;
+        arrival_order_.push_back(static_cast<uint32_t>(worker));
+    }
+
+    /**
+     * @brief Takes one worker's result.
+     * @return true if this was the last missing result. A second result for
+     * the same worker, or one for an unknown worker, is ignored.
+     */
+    bool add(size_t worker, hpcfs_bench::TestResult&& result) {
+        if (worker >= reported_.size() || reported_[worker]) return false;
+        reported_[worker] = true;
+        reported_count_++;
+
+        hpcfs_bench::BatchSummary* summary = batch_.mutable_summary();
+        if (!result.correct()) summary->set_failed(summary->failed() + 1);
+        durations_[worker] = result.duration();
+        duration_.add(result.duration() / 1.0e9, worker);
+        for (const auto& [name, metric] : result.metrics()) {
+            double value = metric_value(metric);
+            if (std::isnan(value)) continue;
+            Running& running = metrics_[name];
+            if (running.count == 0) running.unit = metric.unit().empty() ? metric_unit_for(name) : metric.unit();
+            running.add(value, worker);
+        }
+        *batch_.mutable_resuts(worker) = std::move(result);
+        return complete();
+    }
+
+    bool complete() const { return reported_count_ == reported_.size(); }
+
+    /**
+     * @brief Writes the summaries into batch(). Meant for once complete();
+     * before that, workers that never reported count as empty results.
+     */
+    void finish() {
+        hpcfs_bench::BatchSummary* summary = batch_.mutable_summary();
+        summary->set_workers(reported_.size());
+        summary->clear_arrival_order();
+        for (uint32_t worker : arrival_order_) summary->add_arrival_order(worker);
+        summary->set_arrival_spread_ns(last_arrival_ns_ - first_arrival_ns_);
+        duration_.to_proto(summary->mutable_duration_s(), "s");
+        auto* metrics = summary->mutable_metrics();
+        for (const auto& [name, running] : metrics_) running.to_proto(&(*metrics)[name], running.unit);
+
+        std::vector<uint64_t> sorted;
+        for (size_t w = 0; w < reported_.size(); ++w) {
+            if (reported_[w]) sorted.push_back(durations_[w]);
+        }
+        if (!sorted.empty()) {
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            uint64_t median = sorted[sorted.size() / 2];
+            uint64_t late_ns = static_cast<uint64_t>(median * straggler_fraction_);
+            for (size_t w = 0; w < reported_.size(); ++w) {
+                if (reported_[w] && durations_[w] > median + late_ns) summary->add_stragglers(w);
+            }
+        }
+
+        summarize_cluster_latency(&batch_);
+        summarize_cluster_regions(&batch_, straggler_fraction_);
+        summarize_cluster_timeline(&batch_);
+    }
+
+    hpcfs_bench::TestBatchResult& batch() { return batch_; }
+
+private:
+    /** @brief Welford's online mean/variance plus extremes. */
+    struct Running {
+        uint32_t count = 0;
+        double sum = 0;
+        double mean = 0;
+        double m2 = 0; // Sum of squared deviations from the mean
+        double min = 0;
+        double max = 0;
+        uint32_t min_worker = 0;
+        uint32_t max_worker = 0;
+        std::string unit;
+
+        void add(double value, size_t worker) {
+            count++;
+            sum += value;
+            double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+            if (count == 1 || value < min) {
+                min = value;
+                min_worker = static_cast<uint32_t>(worker);
+            }
+            if (count == 1 || value > max) {
+                max = value;
+                max_worker = static_cast<uint32_t>(worker);
+            }
+        }
+        void to_proto(hpcfs_bench::MetricSummary* out, const std::string& unit) const {
+            out->set_count(count);
+            out->set_sum(sum);
+            out->set_mean(mean);
+            out->set_stddev(count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0);
+            out->set_min(min);
+            out->set_max(max);
+            out->set_min_worker(min_worker);
+            out->set_max_worker(max_worker);
+            out->set_unit(unit);
+        }
+    };
+
+    double straggler_fraction_;
+    hpcfs_bench::TestBatchResult batch_;
+    std::vector<bool> reported_;
+    size_t reported_count_ = 0;
+    std::vector<uint64_t> durations_;
+    std::vector<uint32_t> arrival_order_; // Last execute round only
+    uint64_t first_arrival_ns_ = 0;
+    uint64_t last_arrival_ns_ = 0;
+    Running duration_;
+    std::map<std::string, Running> metrics_;
+};
@@ -5,6 +5,10 @@
 #
 # !! This test requires 'sudo' to drop the OS page cache. !!
 #
+# The cache_read bench (src/fs_test/performance_benchmarks/cache_read_bench.cpp)
+# runs the same cold / hot / warm reads without root: it evicts only the test
+# file and reports page-cache residency next to the bandwidth.
+#
 
 source ./config.sh || { echo "Failed to load config.sh from $(pwd)"; exit 1; }
 set -e
@@ -41,6 +41,9 @@ echo "  -> Multi-client read test launched. Check JSON outputs for aggregate."
 # Test 3: Multi-client metadata stress (shared directory)
 echo "--- Test 3: Multi-Client, Shared Directory Metadata Stress ---"
 # This is a major lock contention test.
+# Note: each node gets its own node_$HOSTNAME directory here. For many
+# clients creating in ONE directory, see the shared_dir_storm bench
+# (src/fs_test/performance_benchmarks/shared_dir_storm_bench.cpp).
 pdsh -w "$CLIENT_HOSTS" \
     "mdtest -n 1000 -i 2 -d $SHARED_MD_DIR/node_\$HOSTNAME"
     